@@ -1,4 +1,8 @@
 """Lovi Home Assistant integration."""
+import logging
+
+_LOGGER = logging.getLogger(__name__)
+
 
 # Lazy imports to avoid hard dependency on homeassistant at import time
 async def async_setup_entry(hass, entry):
@@ -7,21 +11,42 @@ async def async_setup_entry(hass, entry):
     from homeassistant.const import CONF_HOST, CONF_PORT, Platform
     from homeassistant.core import HomeAssistant
 
-    from .const import DOMAIN
+    from .const import CONF_API_KEY, CONF_USE_HTTPS, DATA_BROADCAST_LISTENER, DOMAIN
     from .coordinator import LoviDataUpdateCoordinator
-    from .api import SecureApiClient
+    from .api import ApiCredentials, SecureApiClient
+    from .api.broadcast import BroadcastListener
 
     PLATFORMS: list[Platform] = [Platform.SENSOR, Platform.SWITCH, Platform.NUMBER]
 
     host = entry.data[CONF_HOST]
-    port = entry.data[CONF_PORT]
+    port = entry.options.get(CONF_PORT, entry.data[CONF_PORT])
+    api_key = entry.options.get(CONF_API_KEY) or None
+    use_https = entry.options.get(CONF_USE_HTTPS, entry.data.get(CONF_USE_HTTPS, False))
 
-    # Create API client (use_https=False for local devices)
-    client = SecureApiClient(host, port, use_https=False)
+    # Device certificates are self-signed, so HTTPS only protects the link
+    client = SecureApiClient(
+        host,
+        port,
+        ApiCredentials(api_key=api_key),
+        use_https=use_https,
+        verify_ssl=False,
+    )
     client.set_hass(hass)
 
+    # One multicast socket serves every device
+    listener = hass.data.get(DATA_BROADCAST_LISTENER)
+    if listener is None:
+        listener = BroadcastListener()
+        try:
+            await listener.async_start()
+        except OSError as err:
+            _LOGGER.warning("Lovi broadcast listener unavailable, polling only: %s", err)
+            listener = None
+        else:
+            hass.data[DATA_BROADCAST_LISTENER] = listener
+
     # Create coordinator
-    coordinator = LoviDataUpdateCoordinator(hass, client)
+    coordinator = LoviDataUpdateCoordinator(hass, client, listener)
 
     # Store coordinator in hass data
     hass.data.setdefault(DOMAIN, {})[entry.entry_id] = coordinator
@@ -29,14 +54,27 @@ async def async_setup_entry(hass, entry):
     # Forward setup to platforms
     await hass.config_entries.async_forward_entry_setups(entry, PLATFORMS)
 
+    # Receive state changes as they happen instead of waiting for the next poll
+    coordinator.async_start_stream()
+
+    # Rebuild the client when the key or transport options change
+    entry.async_on_unload(entry.add_update_listener(_async_reload_entry))
+
     return True
 
 
+async def _async_reload_entry(hass, entry):
+    """Reload a config entry after its options changed."""
+    await hass.config_entries.async_reload(entry.entry_id)
+
+
 async def async_unload_entry(hass, entry):
     """Unload a config entry."""
     from homeassistant.const import Platform
     from homeassistant.config_entries import ConfigEntry
 
+    from .const import DATA_BROADCAST_LISTENER, DOMAIN
+
     # Unload platforms
     unload_ok = await hass.config_entries.async_unload_platforms(
         entry, [Platform.SENSOR, Platform.SWITCH, Platform.NUMBER]
@@ -44,6 +82,14 @@ async def async_unload_entry(hass, entry):
 
     if unload_ok:
         # Remove coordinator from hass data
-        hass.data[DOMAIN].pop(entry.entry_id, None)
+        coordinator = hass.data[DOMAIN].pop(entry.entry_id, None)
+        if coordinator is not None:
+            coordinator.detach_broadcast()
+            await coordinator.async_stop_stream()
+
+        if not hass.data[DOMAIN]:
+            listener = hass.data.pop(DATA_BROADCAST_LISTENER, None)
+            if listener is not None:
+                listener.stop()
 
     return unload_ok
@@ -0,0 +1,171 @@
+"""Multicast state broadcasts from Lovi devices.
+
+Devices with broadcasting enabled send a small datagram to a multicast
+group whenever their state changes, plus a heartbeat. One listener serves
+every device in the fleet, so Home Assistant does not need a TCP poll per
+device. Datagrams are not authenticated; only those sent from the
+subscribed device's address are accepted. This mirrors ``firmware/lib/lovi-core/StateBroadcaster.h``.
+
+Example:
+    from api.broadcast import BroadcastListener
+
+    listener = BroadcastListener()
+    await listener.async_start()
+    unsubscribe = listener.subscribe("A0B1C2D3E4F5", "192.168.1.100", handle_data)
+"""
+
+from __future__ import annotations
+
+import asyncio
+import logging
+import socket
+import struct
+from collections.abc import Callable
+from typing import Any
+
+from .exceptions import LoviApiError
+from .telemetry import decode_telemetry
+
+_LOGGER = logging.getLogger(__name__)
+
+BROADCAST_GROUP = "239.255.76.86"
+BROADCAST_PORT = 47476
+BROADCAST_VERSION = 1
+
+# magic, version, reserved, mac
+_HEADER = struct.Struct("<4sBB6s")
+_MAGIC = b"LOVI"
+
+
+def decode_broadcast(packet: bytes) -> tuple[str, dict[str, Any]]:
+    """Decode a state datagram.
+
+    Args:
+        packet: Raw datagram payload
+
+    Returns:
+        Tuple of (device_id, data); device_id matches the ``id`` reported
+        by ``/api/device`` and data uses the ``/api/data`` layout
+
+    Raises:
+        LoviApiError: If the datagram is not a Lovi state broadcast
+    """
+    if len(packet) < _HEADER.size:
+        raise LoviApiError(f"Truncated broadcast: {len(packet)} bytes")
+
+    magic, version, _reserved, mac = _HEADER.unpack_from(packet)
+    if magic != _MAGIC:
+        raise LoviApiError("Not a Lovi broadcast")
+    if version != BROADCAST_VERSION:
+        raise LoviApiError(f"Unsupported broadcast version: {version}")
+
+    return mac.hex().upper(), decode_telemetry(packet[_HEADER.size:])
+
+
+class _BroadcastProtocol(asyncio.DatagramProtocol):
+    """Forward received datagrams to the listener."""
+
+    def __init__(self, listener: BroadcastListener) -> None:
+        """Initialize the protocol.
+
+        Args:
+            listener: Listener that dispatches decoded datagrams
+        """
+        self._listener = listener
+
+    def datagram_received(self, data: bytes, addr: tuple[str, int]) -> None:
+        """Handle a datagram from the multicast group."""
+        self._listener.dispatch(data, addr)
+
+
+class BroadcastListener:
+    """Receive state broadcasts for every device on one socket."""
+
+    def __init__(self, port: int = BROADCAST_PORT) -> None:
+        """Initialize the listener.
+
+        Args:
+            port: UDP port the devices broadcast to
+        """
+        self.port = port
+        self._transport: asyncio.DatagramTransport | None = None
+        self._subscribers: dict[str, tuple[str, Callable[[dict[str, Any]], None]]] = {}
+
+    @property
+    def running(self) -> bool:
+        """Return whether the socket is open."""
+        return self._transport is not None
+
+    async def async_start(self) -> None:
+        """Open the socket and join the multicast group."""
+        if self._transport is not None:
+            return
+
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        sock.bind(("", self.port))
+        membership = struct.pack(
+            "4s4s", socket.inet_aton(BROADCAST_GROUP), socket.inet_aton("0.0.0.0")
+        )
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+        sock.setblocking(False)
+
+        loop = asyncio.get_running_loop()
+        self._transport, _ = await loop.create_datagram_endpoint(
+            lambda: _BroadcastProtocol(self), sock=sock
+        )
+        _LOGGER.debug("Listening for Lovi broadcasts on %s:%d", BROADCAST_GROUP, self.port)
+
+    def stop(self) -> None:
+        """Close the socket."""
+        if self._transport is not None:
+            self._transport.close()
+            self._transport = None
+
+    def subscribe(
+        self,
+        device_id: str,
+        address: str,
+        callback: Callable[[dict[str, Any]], None],
+    ) -> Callable[[], None]:
+        """Receive broadcasts from one device.
+
+        Args:
+            device_id: Device ID as reported by ``/api/device``
+            address: IPv4 address the device sends from
+            callback: Called with decoded data for each datagram
+
+        Returns:
+            Function that removes the subscription
+        """
+        subscription = (address, callback)
+        self._subscribers[device_id] = subscription
+
+        def unsubscribe() -> None:
+            if self._subscribers.get(device_id) is subscription:
+                del self._subscribers[device_id]
+
+        return unsubscribe
+
+    def dispatch(self, packet: bytes, addr: tuple[str, int]) -> None:
+        """Decode a datagram and hand it to the device's subscriber.
+
+        Args:
+            packet: Raw datagram payload
+            addr: Sender address
+        """
+        try:
+            device_id, data = decode_broadcast(packet)
+        except LoviApiError as err:
+            _LOGGER.debug("Ignoring datagram from %s: %s", addr[0], err)
+            return
+
+        subscription = self._subscribers.get(device_id)
+        if subscription is None:
+            return
+
+        address, callback = subscription
+        if addr[0] != address:
+            _LOGGER.debug("Ignoring broadcast for %s from %s", device_id, addr[0])
+            return
+        callback(data)
@@ -19,7 +19,11 @@ Example:
 
 from __future__ import annotations
 
+import asyncio
+import hashlib
+import json
 import logging
+from collections.abc import AsyncIterator
 from dataclasses import dataclass
 from typing import Any
 
@@ -33,6 +37,7 @@ from .exceptions import (
     LoviTimeoutError,
     LoviValidationError,
 )
+from .telemetry import TELEMETRY_CONTENT_TYPE, decode_telemetry
 
 _LOGGER = logging.getLogger(__name__)
 
@@ -41,6 +46,18 @@ DEFAULT_TIMEOUT = 10  # seconds
 DEFAULT_MAX_RETRIES = 3
 DEFAULT_BACKOFF_FACTOR = 2  # seconds
 
+# Push stream configuration
+STREAM_ENDPOINT = "/api/stream"
+STREAM_READ_TIMEOUT = 45  # seconds, device sends a keepalive every 15s
+STREAM_DATA_EVENT = "data"
+
+# Combined info + data + settings endpoint
+STATE_ENDPOINT = "/api/state"
+
+# Firmware update endpoint; uploads need an API key configured on the device
+OTA_ENDPOINT = "/api/ota"
+OTA_TIMEOUT = 120  # seconds, covers the upload and the final verification
+
 
 @dataclass
 class ApiCredentials:
@@ -82,6 +99,7 @@ class SecureApiClient:
         port: int,
         credentials: ApiCredentials | None = None,
         use_https: bool = True,
+        verify_ssl: bool = True,
         timeout: int = DEFAULT_TIMEOUT,
         max_retries: int = DEFAULT_MAX_RETRIES,
         hass: Any = None,
@@ -93,6 +111,8 @@ class SecureApiClient:
             port: Device port
             credentials: API credentials
             use_https: Use HTTPS (default: True)
+            verify_ssl: Verify the device certificate; devices ship
+                self-signed certificates, so local setups disable this
             timeout: Request timeout in seconds
             max_retries: Maximum number of retry attempts
             hass: Home Assistant instance (optional)
@@ -101,11 +121,16 @@ class SecureApiClient:
         self.port = port
         self.credentials = credentials or ApiCredentials()
         self.use_https = use_https
+        # None keeps aiohttp's default verification, False skips it
+        self._ssl: bool | None = None if verify_ssl else False
         self.timeout = timeout
         self.max_retries = max_retries
         self._hass = hass
         self._session: aiohttp.ClientSession | None = None
 
+        # Last ETag and payload per endpoint, for conditional GETs
+        self._etag_cache: dict[str, tuple[str, dict[str, Any]]] = {}
+
         # Build base URL
         scheme = "https" if use_https else "http"
         self.base_url = f"{scheme}://{host}:{port}"
@@ -147,6 +172,7 @@ class SecureApiClient:
         method: str,
         endpoint: str,
         data: dict[str, Any] | None = None,
+        accept: str | None = None,
     ) -> dict[str, Any]:
         """Make an authenticated, secure request.
 
@@ -154,6 +180,11 @@ class SecureApiClient:
             method: HTTP method (GET, POST, etc.)
             endpoint: API endpoint path
             data: Request body (optional)
+            accept: Preferred response type (default: JSON). Binary
+                telemetry responses are decoded into the JSON layout.
+
+        GET requests are sent conditionally when the device previously
+        returned an ETag; a 304 response returns the cached payload.
 
         Returns:
             Response data as dictionary
@@ -166,6 +197,13 @@ class SecureApiClient:
         """
         url = f"{self.base_url}{endpoint}"
         headers = self._get_headers()
+        if accept:
+            headers["Accept"] = accept
+
+        cache_key = f"{endpoint}|{accept or ''}"
+        cached = self._etag_cache.get(cache_key) if method == "GET" else None
+        if cached is not None:
+            headers["If-None-Match"] = cached[0]
 
         for attempt in range(self.max_retries):
             try:
@@ -178,9 +216,22 @@ class SecureApiClient:
                     json=data,
                     headers=headers,
                     timeout=timeout,
+                    ssl=self._ssl,
                 ) as response:
+                    if response.status == 304 and cached is not None:
+                        return cached[1]
+
                     self._handle_response_errors(response, endpoint)
-                    return await response.json()
+                    if response.content_type == TELEMETRY_CONTENT_TYPE:
+                        result = decode_telemetry(await response.read())
+                    else:
+                        result = await response.json()
+
+                    etag = response.headers.get("ETag")
+                    if method == "GET" and etag:
+                        self._etag_cache[cache_key] = (etag, result)
+
+                    return result
 
             except LoviApiError:
                 # Don't retry on API errors
@@ -214,8 +265,6 @@ class SecureApiClient:
         Args:
             attempt: Current attempt number (0-indexed)
         """
-        import asyncio
-
         wait_time = DEFAULT_BACKOFF_FACTOR ** attempt
         _LOGGER.debug(
             "Retry attempt %d for %s, waiting %ds",
@@ -316,6 +365,44 @@ class SecureApiClient:
         """
         return await self.get("/api/status")
 
+    async def async_get_telemetry(self) -> dict[str, Any]:
+        """Get sensor data in the compact binary encoding.
+
+        Firmware without binary support answers with JSON, which is
+        returned as-is.
+
+        Returns:
+            Dictionary with sensor data (presence, motion, distance, etc.)
+        """
+        return await self.request("GET", "/api/data", accept=TELEMETRY_CONTENT_TYPE)
+
+    async def async_get_metrics(self) -> dict[str, Any]:
+        """Get device health and performance metrics.
+
+        Returns:
+            Dictionary with heap, Wi-Fi, HTTP counters and per-task timing
+        """
+        return await self.get("/api/metrics")
+
+    async def async_get_history(self, since: int, limit: int = 0) -> dict[str, Any]:
+        """Get recorded state changes newer than a sequence number.
+
+        Each entry is ``[seq, time_ms, presence, motion, distance_cm]``,
+        where ``time_ms`` is device uptime and bit 0 of presence/motion is
+        the state and bit 1 marks an edge at that entry.
+
+        Args:
+            since: Last sequence number already seen
+            limit: Maximum number of entries (0 for the device default)
+
+        Returns:
+            Dictionary with now_ms, oldest, newest, truncated, entries, next
+        """
+        endpoint = f"/api/history?since={int(since)}"
+        if limit:
+            endpoint += f"&limit={int(limit)}"
+        return await self.get(endpoint)
+
     async def async_get_device_info(self) -> dict[str, Any]:
         """Get device information.
 
@@ -324,16 +411,158 @@ class SecureApiClient:
         """
         return await self.get("/api/device")
 
+    async def async_get_state(
+        self,
+        info_version: str | None = None,
+        settings_version: int | None = None,
+    ) -> dict[str, Any]:
+        """Get device info, sensor data and settings in one request.
+
+        Sections whose version matches the one passed in are returned as
+        None, so callers only pay for what changed.
+
+        Args:
+            info_version: Info version from a previous response
+            settings_version: Settings version from a previous response
+
+        Returns:
+            Dictionary with versions, info, data and settings
+        """
+        params = []
+        if info_version is not None:
+            params.append(f"info={info_version}")
+        if settings_version is not None:
+            params.append(f"settings={int(settings_version)}")
+
+        endpoint = STATE_ENDPOINT
+        if params:
+            endpoint += "?" + "&".join(params)
+        return await self.get(endpoint)
+
+    async def async_stream_data(self) -> AsyncIterator[dict[str, Any]]:
+        """Stream device status data pushed by the device.
+
+        Opens a Server-Sent Events connection to the device, which sends a
+        frame whenever a sensor value changes. Keepalive comments and
+        events other than "data" are skipped. The stream ends when the device closes the connection.
+
+        Yields:
+            Dictionary with device status (presence, motion, distance, etc.)
+
+        Raises:
+            LoviConnectionError: If the connection fails or drops
+            LoviTimeoutError: If no data or keepalive arrives in time
+            LoviApiError: If the device rejects the stream
+        """
+        url = f"{self.base_url}{STREAM_ENDPOINT}"
+        headers = self._get_headers()
+        headers["Accept"] = "text/event-stream"
+        timeout = aiohttp.ClientTimeout(total=None, sock_read=STREAM_READ_TIMEOUT)
+
+        try:
+            session = await self._get_session()
+            async with session.get(
+                url, headers=headers, timeout=timeout, ssl=self._ssl
+            ) as response:
+                self._handle_response_errors(response, STREAM_ENDPOINT)
+
+                data_lines: list[str] = []
+                event = STREAM_DATA_EVENT
+                async for raw_line in response.content:
+                    line = raw_line.decode("utf-8", errors="replace").rstrip("\r\n")
+
+                    if line.startswith("data:"):
+                        data_lines.append(line[5:].lstrip())
+                    elif line.startswith("event:"):
+                        event = line[6:].strip()
+                    elif not line:
+                        payload = "\n".join(data_lines)
+                        is_data = event == STREAM_DATA_EVENT and data_lines
+                        data_lines = []
+                        event = STREAM_DATA_EVENT
+                        if not is_data:
+                            continue
+                        try:
+                            yield json.loads(payload)
+                        except ValueError:
+                            _LOGGER.debug("Ignoring malformed stream frame from %s", self.host)
+
+        except asyncio.TimeoutError:
+            raise LoviTimeoutError(
+                f"Stream from {self.host} timed out after {STREAM_READ_TIMEOUT}s"
+            ) from None
+
+        except aiohttp.ClientError as err:
+            raise LoviConnectionError(f"Stream failed: {err}") from err
+
     async def async_set_settings(self, settings: dict[str, Any]) -> dict[str, Any]:
-        """Update device settings.
+        """Update several device settings in one request.
 
         Args:
             settings: Settings to update (e.g., {"sensitivity": 75, "led": true})
 
         Returns:
-            Dictionary with updated settings
+            Full device state after the update, as from async_get_state
+        """
+        return await self.post(STATE_ENDPOINT, {"settings": settings})
+
+    async def async_get_ota_status(self) -> dict[str, Any]:
+        """Get the state of the current or last firmware update.
+
+        Returns:
+            Dictionary with state, written, size, progress and error
         """
-        return await self.post("/api/settings", settings)
+        return await self.get(OTA_ENDPOINT)
+
+    async def async_update_firmware(self, image: bytes) -> dict[str, Any]:
+        """Upload a firmware image to the device.
+
+        The device writes the image to flash as it arrives and checks it
+        against the MD5 sent here before rebooting into it, so a corrupted
+        transfer leaves the running firmware in place.
+
+        Args:
+            image: Firmware binary as built by PlatformIO
+
+        Returns:
+            Final update status, as from async_get_ota_status
+
+        Raises:
+            LoviAuthenticationError: If the API key is missing or wrong
+            LoviApiError: If the device rejects or fails to verify the image
+            LoviConnectionError: If the upload is interrupted
+        """
+        md5 = hashlib.md5(image).hexdigest()
+        endpoint = f"{OTA_ENDPOINT}?md5={md5}&size={len(image)}"
+        headers = self._get_headers()
+        # aiohttp sets the multipart boundary itself.
+        headers.pop("Content-Type", None)
+
+        form = aiohttp.FormData()
+        form.add_field(
+            "firmware",
+            image,
+            filename="firmware.bin",
+            content_type="application/octet-stream",
+        )
+
+        try:
+            session = await self._get_session()
+            async with session.post(
+                f"{self.base_url}{endpoint}",
+                data=form,
+                headers=headers,
+                timeout=aiohttp.ClientTimeout(total=OTA_TIMEOUT),
+                ssl=self._ssl,
+            ) as response:
+                self._handle_response_errors(response, OTA_ENDPOINT)
+                return await response.json()
+        except asyncio.TimeoutError:
+            raise LoviTimeoutError(
+                f"Firmware upload to {self.host} timed out"
+            ) from None
+        except aiohttp.ClientError as err:
+            raise LoviConnectionError(f"Firmware upload failed: {err}") from err
 
     async def async_set_led(self, enabled: bool) -> dict[str, Any]:
         """Set LED on/off state.
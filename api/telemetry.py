@@ -0,0 +1,74 @@
+"""Binary telemetry decoding for Lovi devices.
+
+Devices can answer ``/api/data`` with a compact fixed-layout frame instead
+of JSON when the request carries ``Accept: application/x-lovi-telemetry``.
+This mirrors ``firmware/lib/lovi-core/Telemetry.h``.
+
+Example:
+    from api.telemetry import decode_telemetry
+
+    data = decode_telemetry(payload)
+    data["presence"]  # True
+"""
+
+from __future__ import annotations
+
+import struct
+from typing import Any
+
+from .exceptions import LoviApiError
+
+TELEMETRY_CONTENT_TYPE = "application/x-lovi-telemetry"
+TELEMETRY_VERSION = 1
+
+# version, flags, changed, sensitivity, seq, uptime, distance, temperature, humidity
+_FRAME_V1 = struct.Struct("<BBBBIIHhH")
+
+
+def decode_telemetry(payload: bytes) -> dict[str, Any]:
+    """Decode a binary telemetry frame into the JSON data layout.
+
+    Args:
+        payload: Raw response body
+
+    Returns:
+        Dictionary with the same keys as the JSON /api/data response
+
+    Raises:
+        LoviApiError: If the frame is truncated or of an unknown version
+    """
+    if not payload:
+        raise LoviApiError("Empty telemetry frame")
+
+    version = payload[0]
+    if version != TELEMETRY_VERSION:
+        raise LoviApiError(f"Unsupported telemetry version: {version}")
+
+    if len(payload) < _FRAME_V1.size:
+        raise LoviApiError(
+            f"Truncated telemetry frame: {len(payload)} < {_FRAME_V1.size} bytes"
+        )
+
+    (
+        _version,
+        flags,
+        changed,
+        sensitivity,
+        seq,
+        uptime,
+        distance_mm,
+        temperature_centi,
+        humidity_centi,
+    ) = _FRAME_V1.unpack_from(payload)
+
+    return {
+        "presence": bool(flags & 0x01),
+        "motion": bool(flags & 0x02),
+        "distance": distance_mm / 1000,
+        "sensitivity": sensitivity,
+        "temperature": temperature_centi / 100,
+        "humidity": humidity_centi / 100,
+        "uptime": uptime,
+        "seq": seq,
+        "changed": changed,
+    }
@@ -11,7 +11,7 @@ from homeassistant.data_entry_flow import FlowResult
 
 from .api import ApiCredentials, SecureApiClient
 from .api.exceptions import LoviConnectionError, LoviApiError
-from .const import DEFAULT_PORT, DOMAIN
+from .const import CONF_API_KEY, CONF_USE_HTTPS, DEFAULT_PORT, DOMAIN
 
 try:
     from homeassistant.components.zeroconf import ZeroconfServiceInfo
@@ -172,6 +172,7 @@ class LoviConfigFlow(ConfigFlow, domain=DOMAIN):
         model = properties.get("model", "Lovi Device")
         firmware_version = properties.get("firmware_version", "unknown")
         capabilities = properties.get("capabilities", "")
+        use_https = properties.get("tls") == "1"
 
         if not mac_address:
             _LOGGER.warning("No MAC address in discovery info, aborting")
@@ -190,6 +191,7 @@ class LoviConfigFlow(ConfigFlow, domain=DOMAIN):
             "model": model,
             "firmware_version": firmware_version,
             "capabilities": capabilities,
+            CONF_USE_HTTPS: use_https,
         }
 
         self.context["title_placeholders"] = {
@@ -230,7 +232,8 @@ class LoviConfigFlow(ConfigFlow, domain=DOMAIN):
             host=host,
             port=port,
             credentials=ApiCredentials(),
-            use_https=False,
+            use_https=discovery_data.get(CONF_USE_HTTPS, False),
+            verify_ssl=False,
             timeout=5,
         )
 
@@ -272,6 +275,7 @@ class LoviConfigFlow(ConfigFlow, domain=DOMAIN):
         entry_data = {
             CONF_HOST: host,
             CONF_PORT: port,
+            CONF_USE_HTTPS: discovery_info.get(CONF_USE_HTTPS, False),
         }
 
         if validated_data.get("api_validated"):
@@ -313,8 +317,20 @@ class LoviOptionsFlowHandler(OptionsFlow):
         options = {
             vol.Optional(
                 CONF_PORT,
-                default=self.config_entry.data.get(CONF_PORT, DEFAULT_PORT),
+                default=self.config_entry.options.get(
+                    CONF_PORT, self.config_entry.data.get(CONF_PORT, DEFAULT_PORT)
+                ),
             ): int,
+            vol.Optional(
+                CONF_API_KEY,
+                default=self.config_entry.options.get(CONF_API_KEY, ""),
+            ): str,
+            vol.Optional(
+                CONF_USE_HTTPS,
+                default=self.config_entry.options.get(
+                    CONF_USE_HTTPS, self.config_entry.data.get(CONF_USE_HTTPS, False)
+                ),
+            ): bool,
         }
 
         return self.async_show_form(step_id="init", data_schema=vol.Schema(options))
@@ -11,6 +11,8 @@ CONF_HOST = "host"
 CONF_PORT = "port"
 CONF_USERNAME = "username"
 CONF_PASSWORD = "password"
+CONF_API_KEY = "api_key"
+CONF_USE_HTTPS = "use_https"
 
 # API Constants
 DEFAULT_PORT = 80
@@ -19,6 +21,12 @@ DEFAULT_TIMEOUT = 10
 # Device info
 MANUFACTURER = "Lovi"
 
+# Fired for presence/motion edges recovered from device history
+EVENT_HISTORY = f"{DOMAIN}_history"
+
+# hass.data key for the fleet-wide broadcast listener
+DATA_BROADCAST_LISTENER = f"{DOMAIN}_broadcast"
+
 # Presence sensor specific
 PRESENCE_GEN_ONE = "presence_gen_one"
 
@@ -1,22 +1,40 @@
 """Data update coordinator for Lovi devices."""
 from __future__ import annotations
 
+import asyncio
 import logging
+import socket
+import time
 from datetime import timedelta
+from collections.abc import Callable
 from typing import Any
 
-from homeassistant.core import HomeAssistant
+from homeassistant.core import HomeAssistant, callback
 from homeassistant.helpers.update_coordinator import DataUpdateCoordinator
 from homeassistant.helpers.update_coordinator import UpdateFailed
+from homeassistant.util import dt as dt_util
 
 from .api import SecureApiClient
+from .api import LoviApiError
+from .api import LoviAuthenticationError
 from .api import LoviConnectionError
-from .const import DOMAIN
+from .api import LoviTimeoutError
+from .api.broadcast import BroadcastListener
+from .const import DOMAIN, EVENT_HISTORY
 from .devices import LoviDevice
 from .devices.registry import registry
 
 _LOGGER = logging.getLogger(__name__)
 
+# Delay before reopening a dropped push stream
+STREAM_RETRY_DELAY = 10  # seconds
+
+# Metrics are diagnostic only, so fetch them every Nth refresh
+METRICS_REFRESH_EVERY = 10
+
+# Broadcasts stand in for a poll until two heartbeats (25 s) were missed
+BROADCAST_TIMEOUT = 60  # seconds
+
 
 class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
     """Data update coordinator for Lovi devices.
@@ -24,14 +42,23 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
     This coordinator manages data fetching from Lovi devices and
     automatically creates the appropriate device instance based on
     the device type reported by the device.
+
+    Polling remains the source of truth for recovery; when the device
+    supports it, a push stream delivers changes between polls.
     """
 
-    def __init__(self, hass: HomeAssistant, client: SecureApiClient) -> None:
+    def __init__(
+        self,
+        hass: HomeAssistant,
+        client: SecureApiClient,
+        broadcast_listener: BroadcastListener | None = None,
+    ) -> None:
         """Initialize the coordinator.
 
         Args:
             hass: Home Assistant instance
             client: API client for device communication
+            broadcast_listener: Shared listener for multicast state, if any
         """
         super().__init__(
             hass,
@@ -41,6 +68,13 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
         )
         self.client = client
         self._device: LoviDevice | None = None
+        self._stream_task: asyncio.Task | None = None
+        self._metrics: dict[str, Any] = {}
+        self._last_seq: int | None = None
+        self._refresh_count = 0
+        self._broadcast_listener = broadcast_listener
+        self._broadcast_unsub: Callable[[], None] | None = None
+        self._last_broadcast: float | None = None
 
     async def _async_update_data(self) -> dict[str, Any]:
         """Fetch data from the device.
@@ -52,11 +86,12 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
             UpdateFailed: If connection fails
         """
         try:
-            data = await self.client.async_get_data()
+            # Every Nth refresh re-reads the full state so settings changed
+            # elsewhere show up even while broadcasts or pushes carry the data
+            full_refresh = self._refresh_count % METRICS_REFRESH_EVERY == 0
 
-            # Create device instance if not exists
             if self._device is None:
-                device_info = await self.client.async_get_device_info()
+                data, device_info = await self._async_fetch_state()
                 device_type = device_info.get("type", "presence_gen_one")
 
                 # Use registry to create device instance
@@ -66,10 +101,24 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
                     self._device.name,
                     self._device.device_type,
                 )
+                await self._async_attach_broadcast(data)
+            elif full_refresh:
+                data, _ = await self._async_fetch_state()
+            elif self._broadcast_fresh():
+                # The last broadcast already delivered this poll's data
+                data = {}
+            else:
+                data = await self.client.async_get_telemetry()
 
             # Update device state with new data
+            data = self._merge_data(data)
+            await self._async_backfill(data)
             self._device.update(data)
 
+            if full_refresh:
+                await self._async_update_metrics()
+            self._refresh_count += 1
+
             return data
 
         except LoviConnectionError as err:
@@ -77,6 +126,258 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
         except ValueError as err:
             raise UpdateFailed(f"Device error: {err}") from err
 
+    async def _async_fetch_state(self) -> tuple[dict[str, Any], dict[str, Any]]:
+        """Fetch sensor data, settings and device info.
+
+        Uses the combined state endpoint, falling back to separate data
+        and info requests on firmware that does not have it.
+
+        Returns:
+            Tuple of (data, device_info)
+        """
+        try:
+            state = await self.client.async_get_state()
+        except LoviApiError as err:
+            if err.status_code != 404:
+                raise
+            data = await self.client.async_get_telemetry()
+            return data, await self.client.async_get_device_info()
+
+        return self._merge_state(state), state.get("info") or {}
+
+    def _merge_data(self, data: dict[str, Any]) -> dict[str, Any]:
+        """Overlay a partial update on the last known data.
+
+        Telemetry and broadcast frames carry sensor fields only, so the
+        settings from the last full state are kept.
+
+        Args:
+            data: Fields received from the device
+
+        Returns:
+            Complete data for the device
+        """
+        merged = dict(self.data or {})
+        merged.update(data)
+        return merged
+
+    @staticmethod
+    def _merge_state(state: dict[str, Any]) -> dict[str, Any]:
+        """Flatten a state response into the data layout devices expect.
+
+        Args:
+            state: Response from the state endpoint
+
+        Returns:
+            Sensor data with settings merged in
+        """
+        data = dict(state.get("settings") or {})
+        data.update(state.get("data") or {})
+        return data
+
+    async def async_set_settings(self, settings: dict[str, Any]) -> None:
+        """Write several settings to the device in one request.
+
+        Args:
+            settings: Settings to update (e.g., {"sensitivity": 75, "led": True})
+        """
+        state = await self.client.async_set_settings(settings)
+        if self._device is not None:
+            data = self._merge_data(self._merge_state(state))
+            self._device.update(data)
+            self.async_set_updated_data(data)
+
+    async def _async_attach_broadcast(self, data: dict[str, Any]) -> None:
+        """Follow the device through the fleet broadcast listener.
+
+        Broadcasts are unauthenticated, so only datagrams from the device's
+        address are accepted. Unsecured devices that support broadcasting
+        but have it switched off are asked to turn it on; devices with an
+        API key or HTTPS keep broadcasts off unless enabled on the device.
+
+        Args:
+            data: State from the first refresh
+        """
+        if self._broadcast_listener is None or self._broadcast_unsub is not None:
+            return
+
+        try:
+            address = await self.hass.async_add_executor_job(
+                socket.gethostbyname, self.client.host
+            )
+        except OSError as err:
+            _LOGGER.debug("Not following broadcasts from %s: %s", self.client.host, err)
+            return
+
+        self._broadcast_unsub = self._broadcast_listener.subscribe(
+            self.device_id, address, self._handle_broadcast
+        )
+
+        secured = self.client.use_https or self.client.credentials.api_key is not None
+        if data.get("broadcast") is False and not secured:
+            try:
+                await self.client.async_set_settings({"broadcast": True})
+            except (LoviApiError, LoviConnectionError) as err:
+                _LOGGER.debug("Could not enable broadcasts on %s: %s", self.client.host, err)
+
+    def detach_broadcast(self) -> None:
+        """Stop following the device's broadcasts."""
+        if self._broadcast_unsub is not None:
+            self._broadcast_unsub()
+            self._broadcast_unsub = None
+
+    @callback
+    def _handle_broadcast(self, data: dict[str, Any]) -> None:
+        """Apply a state datagram from the device.
+
+        Heartbeats carry an unchanged sequence number; they only mark the
+        broadcast as fresh, so polls skip the telemetry request.
+
+        Args:
+            data: Decoded broadcast data
+        """
+        if self._device is None:
+            return
+
+        self._last_broadcast = time.monotonic()
+        if data.get("seq") == self._last_seq:
+            return
+
+        self.hass.async_create_task(self._async_apply_push(data))
+
+    def _broadcast_fresh(self) -> bool:
+        """Return whether a broadcast arrived recently enough to skip a poll."""
+        return (
+            self._last_broadcast is not None
+            and time.monotonic() - self._last_broadcast < BROADCAST_TIMEOUT
+        )
+
+    async def _async_apply_push(self, data: dict[str, Any]) -> None:
+        """Apply data pushed by the device outside of a poll.
+
+        Listeners are notified without rescheduling the next refresh, so
+        metrics and settings keep refreshing on a busy device.
+
+        Args:
+            data: Sensor data from the stream or a broadcast
+        """
+        data = self._merge_data(data)
+        await self._async_backfill(data)
+        self._device.update(data)
+        self.data = data
+        self.async_update_listeners()
+
+    async def _async_update_metrics(self) -> None:
+        """Fetch diagnostic metrics, keeping the last values on failure."""
+        try:
+            self._metrics = await self.client.async_get_metrics()
+        except (LoviApiError, LoviConnectionError) as err:
+            _LOGGER.debug("Metrics unavailable from %s: %s", self.client.host, err)
+
+    async def _async_backfill(self, data: dict[str, Any]) -> None:
+        """Recover presence/motion edges that happened between updates.
+
+        When the sequence number jumped by more than one, the missed state
+        changes are fetched from the device history in one request and
+        replayed as events on the bus.
+
+        Args:
+            data: Latest data from the device
+        """
+        seq = data.get("seq")
+        if seq is None:
+            return
+
+        last_seq = self._last_seq
+        self._last_seq = seq
+
+        # Nothing missed, or the device restarted and its history is new
+        if last_seq is None or seq <= last_seq + 1:
+            return
+
+        try:
+            history = await self.client.async_get_history(last_seq)
+        except (LoviApiError, LoviConnectionError) as err:
+            _LOGGER.debug("History unavailable from %s: %s", self.client.host, err)
+            return
+
+        if history.get("truncated"):
+            _LOGGER.debug("History from %s overflowed, some edges are lost", self.client.host)
+
+        now = dt_util.utcnow()
+        now_ms = history.get("now_ms", 0)
+        for entry_seq, time_ms, presence, motion, distance_cm in history.get("entries", []):
+            if entry_seq >= seq:
+                break
+            if not (presence & 2 or motion & 2):
+                continue
+
+            self.hass.bus.async_fire(
+                EVENT_HISTORY,
+                {
+                    "device_id": self.device_id,
+                    "seq": entry_seq,
+                    "timestamp": (now - timedelta(milliseconds=now_ms - time_ms)).isoformat(),
+                    "presence": bool(presence & 1),
+                    "motion": bool(motion & 1),
+                    "distance": distance_cm / 100,
+                },
+            )
+
+    @property
+    def metrics(self) -> dict[str, Any]:
+        """Return the last diagnostic metrics reported by the device.
+
+        Returns:
+            Metrics dictionary, empty if the device does not report any
+        """
+        return self._metrics
+
+    def async_start_stream(self) -> None:
+        """Start listening for pushed state changes from the device."""
+        if self._stream_task is None or self._stream_task.done():
+            self._stream_task = self.hass.async_create_background_task(
+                self._async_stream_loop(),
+                name=f"{DOMAIN} stream {self.client.host}",
+            )
+
+    async def async_stop_stream(self) -> None:
+        """Stop listening for pushed state changes."""
+        if self._stream_task is not None:
+            self._stream_task.cancel()
+            try:
+                await self._stream_task
+            except asyncio.CancelledError:
+                pass
+            self._stream_task = None
+
+    async def _async_stream_loop(self) -> None:
+        """Consume the device push stream, reconnecting when it drops."""
+        while True:
+            try:
+                async for data in self.client.async_stream_data():
+                    if self._device is None:
+                        continue
+                    await self._async_apply_push(data)
+
+            except LoviAuthenticationError as err:
+                _LOGGER.warning("Stream from %s not authorized: %s", self.client.host, err)
+                return
+
+            except LoviApiError as err:
+                if err.status_code == 404:
+                    _LOGGER.debug(
+                        "%s does not support push updates, polling only",
+                        self.client.host,
+                    )
+                    return
+                _LOGGER.debug("Stream from %s rejected: %s", self.client.host, err)
+
+            except (LoviConnectionError, LoviTimeoutError) as err:
+                _LOGGER.debug("Stream from %s dropped: %s", self.client.host, err)
+
+            await asyncio.sleep(STREAM_RETRY_DELAY)
+
     @property
     def device(self) -> LoviDevice | None:
         """Return the device instance.
@@ -118,7 +419,10 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
         """
         if self._device is None:
             raise ValueError("Device not initialized")
-        return await self._device.async_set_sensitivity(value)
+        if not await self._device.async_set_sensitivity(value):
+            return False
+        await self.async_set_settings({"sensitivity": value})
+        return True
 
     async def async_set_led(self, enabled: bool) -> bool:
         """Set device LED state.
@@ -134,7 +438,10 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
         """
         if self._device is None:
             raise ValueError("Device not initialized")
-        return await self._device.async_set_led(enabled)
+        if not await self._device.async_set_led(enabled):
+            return False
+        await self.async_set_settings({"led": enabled})
+        return True
 
     async def async_set_led_brightness(self, brightness: int) -> bool:
         """Set device LED brightness.
@@ -150,4 +457,7 @@ class LoviDataUpdateCoordinator(DataUpdateCoordinator[dict[str, Any]]):
         """
         if self._device is None:
             raise ValueError("Device not initialized")
-        return await self._device.async_set_led_brightness(brightness)
+        if not await self._device.async_set_led_brightness(brightness):
+            return False
+        await self.async_set_settings({"led_brightness": brightness})
+        return True
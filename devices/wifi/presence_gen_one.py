@@ -60,9 +60,11 @@ class PresenceGenOne(LoviDevice):
     and distance information.
 
     API Endpoints:
-    - GET /api/status - Device status
-    - GET /api/presence - Presence detection data
-    - POST /api/settings - Update settings (sensitivity, LED)
+    - GET /api/data - Sensor data (JSON or binary telemetry)
+    - GET /api/state - Device info, sensor data and settings together
+    - POST /api/state - Update settings (sensitivity, LED) in one write
+    - GET /api/ota - Progress of the current or last firmware update
+    - POST /api/ota - Upload a firmware image (API key required)
     """
 
     DEVICE_TYPE = "presence_gen_one"
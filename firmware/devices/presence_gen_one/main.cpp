@@ -1,100 +1,240 @@
 #include <Arduino.h>
-#include <EEPROM.h>
 #include <ESP8266WiFi.h>
 #include <CaptivePortal.h>
 #include <Device.h>
+#include <ConnectionManager.h>
+#include <Scheduler.h>
+#include <InputCapture.h>
+#include <Log.h>
+#include <RadarParser.h>
+#include <SignalFilter.h>
+#include <PowerManager.h>
 
 using namespace lovi;
 
 #define FIRMWARE_VERSION "1.0.0"
 #define LED_PIN 16
-#define WIFI_TIMEOUT 30
+#define PRESENCE_PIN 14
+#define MOTION_PIN 12
+#define SENSOR_PERIOD_MS 50
+#define HTTP_PERIOD_MS 5
+#define MDNS_PERIOD_MS 100
+#define WIFI_PERIOD_MS 100
+#define PORTAL_PERIOD_MS 10
+#define BROADCAST_PERIOD_MS 50
+#define RADAR_TIMEOUT_MS 1000
+#define HTTP_SLEEP_PERIOD_MS 50
+#define CPU_PERIOD_MS 100
 
-class PresenceGenOneDevice : public Device {
+#if LOVI_TLS
+#include "tls_credentials.h"
+#define API_PORT 443
+#else
+#define API_PORT 80
+#endif
+
+#ifndef POWER_MODE
+#define POWER_MODE PowerMode::PERFORMANCE
+#endif
+
+class PresenceGenOneDevice : public DeviceModel<DeviceType::PRESENCE_GEN_ONE> {
 public:
     PresenceGenOneDevice() 
-        : Device("Lovi-Presence", DeviceType::PRESENCE_GEN_ONE, FIRMWARE_VERSION) {
-        
-        DeviceInfo::Capabilities caps;
-        caps.hasPresence = true;
-        caps.hasMotion = true;
-        caps.hasTemperature = true;
-        caps.hasHumidity = true;
-        caps.hasSensitivity = true;
-        caps.maxDistance = 5.0f;
-        _setCapabilities(caps);
+        : DeviceModel("Lovi-Presence", FIRMWARE_VERSION)
+        , _presenceLine(_inputs.addLine(PRESENCE_PIN))
+        , _motionLine(_inputs.addLine(MOTION_PIN))
+        , _lastEdgeUs(0)
+        , _distanceCm(0) {
     }
 
     void begin() override {
         Device::begin();
+        _inputs.begin();
+        _radar.begin(&Serial);
+    }
+
+    void pauseSampling() override {
+        _inputs.end();
+    }
+
+    void resumeSampling() override {
+        // Radar bytes that overflowed the UART buffer meanwhile are resynced by the parser.
+        _distanceCm = _filter.distanceCm(0);
+        _inputs.begin();
+    }
+
+    void sample() override {
+        // A backlog this deep means 80 MHz is not keeping up with the radar.
+        getCpuGovernor().setDemand(CpuGovernor::DEMAND_RADAR,
+                                   _radar.available() > static_cast<int>(RadarParser::RX_BUFFER_SIZE / 2));
+        if (_radar.poll()) {
+            _distanceCm = _filter.distanceCm(_radarDistanceCm());
+        } else if (_distanceCm && millis() - _radar.getReportTimeMs() > RADAR_TIMEOUT_MS) {
+            _distanceCm = _filter.distanceCm(0);
+        }
+
+        // Apply queued edges one by one so each transition keeps its timestamp.
+        InputEdge edge;
+        while (_inputs.poll(edge)) {
+            _lastEdgeUs = edge.timeUs;
+            _publish(_lastEdgeUs);
+        }
+        // Transitions released here come from a debounce hold expiring, so
+        // they are stamped with the current time rather than the old edge.
+        _publish(0);
     }
 
-    void update() override {
-        Device::update();
-        
+private:
+    InputCapture _inputs;
+    RadarParser _radar;
+    SensorFilter _filter;
+    int8_t _presenceLine;
+    int8_t _motionLine;
+    uint32_t _lastEdgeUs;
+    uint16_t _distanceCm;
+
+    void _publish(uint32_t edgeTimeUs) {
+        uint32_t now = millis();
         SensorData data;
-        data.presence = false;
-        data.motion = false;
-        data.distance = 0.0f;
-        data.sensitivity = 50;
-        data.temperature = 22.5f;
-        data.humidity = 45.0f;
-        data.uptime = millis() / 1000;
+        data.presence = _filter.presence(_inputs.isActive(_presenceLine), now);
+        data.motion = _filter.motion(_inputs.isActive(_motionLine), now);
+        data.edgeTimeUs = edgeTimeUs;
+        data.distance = _distanceCm / 100.0f;
+        data.sensitivity = getSettings().sensitivity;
+        if constexpr (has<SENSOR_TEMPERATURE>()) {
+            data.temperature = 22.5f;
+        }
+        if constexpr (has<SENSOR_HUMIDITY>()) {
+            data.humidity = 45.0f;
+        }
+        data.uptime = now / 1000;
         _setSensorData(data);
     }
+
+    uint16_t _radarDistanceCm() const {
+        const RadarReport& report = _radar.getReport();
+        if (report.state == RadarTargetState::NONE) {
+            return 0;
+        }
+        return report.detectionDistanceCm;
+    }
 };
 
 PresenceGenOneDevice device;
 CaptivePortal portal(LED_PIN);
+ConnectionManager connection(&device, API_PORT);
+Scheduler scheduler(&device.getMetrics());
+PowerManager power(&scheduler, &device.getMetrics());
+int8_t sensorTask = -1;
+int8_t broadcastTask = -1;
+bool pausedForOta = false;
 
-void connectToWiFi(const char* ssid, const char* password) {
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(ssid, password);
-    
-    Serial.print("Connecting to WiFi");
-    int timeout = 0;
-    while (WiFi.status() != WL_CONNECTED && timeout < WIFI_TIMEOUT) {
-        delay(1000);
-        Serial.print(".");
-        timeout++;
+void onConnectionStateChange(ConnectionState state) {
+    if (state == ConnectionState::CONNECTED) {
+        ConfigManager* configManager = portal.getConfigManager();
+        if (configManager->setNetworkCache(connection.getNetworkCache())) {
+            configManager->saveConfig();
+        }
+    } else if (state == ConnectionState::PORTAL) {
+        Log.println("WiFi unreachable - starting captive portal");
+        portal.enterConfigMode();
     }
-    Serial.println();
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.print("Connected! IP: ");
-        Serial.println(WiFi.localIP());
-        
-        device.begin();
-        device.startMDNS(80);
-        device.startAPIServer(80);
+}
+
+void onProvisioned() {
+    ConfigManager* configManager = portal.getConfigManager();
+    device.setApiKey(configManager->getApiKey());
+    connection.begin(configManager->getSSID(), configManager->getPassword());
+}
+
+void onSettingsChange(const DeviceSettings& settings) {
+    ConfigManager* configManager = portal.getConfigManager();
+    if (configManager->getSensitivity() != settings.sensitivity
+        || configManager->getBroadcast() != settings.broadcast) {
+        configManager->setSensitivity(settings.sensitivity);
+        configManager->setBroadcast(settings.broadcast);
+        configManager->saveConfig();
+    }
+
+    LEDController* led = portal.getLEDController();
+    if (!settings.ledEnabled) {
+        led->off();
+    } else if (settings.ledBrightness == 255) {
+        led->on();
     } else {
-        Serial.println("WiFi connection failed!");
+        led->setBrightness(settings.ledBrightness);
+    }
+}
+
+void onOtaStateChange(OtaState state) {
+    bool updating = state == OtaState::RECEIVING;
+    scheduler.setEnabled(sensorTask, !updating);
+    scheduler.setEnabled(broadcastTask, !updating);
+    device.setMdnsTxt("state", updating ? "updating" : "ready");
+    // A failed image leaves sampling as this handler found it.
+    if (updating && !pausedForOta) {
+        device.pauseSampling();
+        pausedForOta = true;
+    } else if (state == OtaState::FAILED && pausedForOta) {
+        device.resumeSampling();
+        pausedForOta = false;
     }
 }
 
 void setup() {
-    Serial.begin(115200);
+    // The radar owns UART0, swapped onto GPIO13/15, so logs go to UART1
+    // (GPIO2, TX only) and never reach the radar's RX (see platformio.ini).
+    Serial1.begin(115200);
+    Serial.setRxBufferSize(RadarParser::RX_BUFFER_SIZE);
+    Serial.begin(RadarParser::BAUD_RATE);
+    Serial.swap();
     delay(1000);
-    Serial.println("Starting Presence Gen One...");
+    Log.println("Starting Presence Gen One...");
+
+    device.begin();
 
-    EEPROM.begin(512);
-    
     ConfigManager* configManager = portal.getConfigManager();
     configManager->loadConfig();
     
+    DeviceSettings settings = device.getSettings();
+    settings.sensitivity = configManager->getSensitivity();
+    settings.broadcast = configManager->getBroadcast();
+    device.applySettings(settings);
+    device.onSettingsChange(onSettingsChange);
+    device.setApiKey(configManager->getApiKey());
+#if LOVI_TLS
+    device.setCertificate(TLS_CERT_PEM, TLS_KEY_PEM);
+#endif
+    device.getOtaUpdater().onStateChange(onOtaStateChange);
+    device.setMdnsTxt("state", "ready");
+
     const char* ssid = configManager->getSSID();
+    connection.onStateChange(onConnectionStateChange);
+    portal.onProvisioned(onProvisioned);
     
     if (strlen(ssid) == 0) {
-        Serial.println("No WiFi credentials found - starting captive portal");
+        Log.println("No WiFi credentials found - starting captive portal");
         portal.enterConfigMode();
     } else {
-        Serial.println("WiFi credentials found - connecting...");
+        Log.println("WiFi credentials found - connecting...");
         portal.begin();
-        connectToWiFi(ssid, configManager->getPassword());
+        connection.begin(ssid, configManager->getPassword(), &configManager->getNetworkCache());
     }
+
+    sensorTask = scheduler.addTask("sensor", SENSOR_PERIOD_MS, []() { device.sample(); }, 10);
+    int8_t httpTask = scheduler.addTask("http", HTTP_PERIOD_MS, []() { device.updateAPIServer(); });
+    scheduler.addTask("mdns", MDNS_PERIOD_MS, []() { device.updateMDNS(); });
+    broadcastTask = scheduler.addTask("broadcast", BROADCAST_PERIOD_MS, []() { device.updateBroadcast(); });
+    scheduler.addTask("wifi", WIFI_PERIOD_MS, []() { connection.update(); });
+    scheduler.addTask("portal", PORTAL_PERIOD_MS, []() { portal.update(); });
+    scheduler.addTask("cpu", CPU_PERIOD_MS, []() { device.getCpuGovernor().update(); });
+
+    // Requests only arrive on DTIM wakes while sleeping, so faster polling buys nothing.
+    power.throttleTask(httpTask, HTTP_SLEEP_PERIOD_MS);
+    power.addWakePin(PRESENCE_PIN);
+    power.setMode(POWER_MODE);
 }
 
 void loop() {
-    portal.update();
-    device.update();
+    scheduler.run();
 }
@@ -1,54 +1,107 @@
 #include <Arduino.h>
-#include <EEPROM.h>
 #include <CaptivePortal.h>
 #include <Device.h>
-#include <ConfigManager.h>
-#include <LEDController.h>
+#include <ConnectionManager.h>
+#include <Scheduler.h>
+#include <Log.h>
 
 using namespace lovi;
 
 #define DEVICE_NAME "Lovi-Test"
 #define FIRMWARE_VERSION "1.0.0"
 #define LED_PIN 16
+#define API_PORT 80
+#define SENSOR_PERIOD_MS 1000
+#define HTTP_PERIOD_MS 5
+#define MDNS_PERIOD_MS 100
+#define WIFI_PERIOD_MS 100
+#define PORTAL_PERIOD_MS 10
 
-class TestDevice : public Device {
+class TestDevice : public DeviceModel<DeviceType::TEST_DEVICE> {
 public:
-    TestDevice() : Device(DEVICE_NAME, FIRMWARE_VERSION) {}
+    TestDevice() : DeviceModel(DEVICE_NAME, FIRMWARE_VERSION) {}
 
-    void begin(ConfigManager* configManager, LEDController* ledController) override {
-        Serial.println("Test Device: Initialized");
+    void begin() override {
+        Device::begin();
+        Log.println("Test Device: Initialized");
     }
 
-    void update() override {
-        delay(1);
+    // Uptime is the only sensor, so the API reports it once a second.
+    void sample() override {
+        SensorData data;
+        data.uptime = millis() / 1000;
+        _setSensorData(data);
     }
 };
 
 TestDevice device;
-CaptivePortal portal(&device, LED_PIN);
+CaptivePortal portal(LED_PIN);
+ConnectionManager connection(&device, API_PORT);
+Scheduler scheduler(&device.getMetrics());
+
+void onConnectionStateChange(ConnectionState state) {
+    if (state == ConnectionState::CONNECTED) {
+        ConfigManager* configManager = portal.getConfigManager();
+        if (configManager->setNetworkCache(connection.getNetworkCache())) {
+            configManager->saveConfig();
+        }
+    } else if (state == ConnectionState::PORTAL) {
+        Log.println("WiFi unreachable - starting captive portal");
+        portal.enterConfigMode();
+    }
+}
+
+void onProvisioned() {
+    ConfigManager* configManager = portal.getConfigManager();
+    device.setApiKey(configManager->getApiKey());
+    connection.begin(configManager->getSSID(), configManager->getPassword());
+}
+
+// The LED settings are the API this device exists to exercise.
+void onSettingsChange(const DeviceSettings& settings) {
+    LEDController* led = portal.getLEDController();
+    if (!settings.ledEnabled) {
+        led->off();
+    } else if (settings.ledBrightness == 255) {
+        led->on();
+    } else {
+        led->setBrightness(settings.ledBrightness);
+    }
+}
 
 void setup() {
     Serial.begin(115200);
     delay(1000);
-    Serial.println("Starting...");
-
-    EEPROM.begin(512);
-    
-    ConfigManager configManager;
-    configManager.begin();
-    configManager.loadConfig();
-    
-    const char* ssid = configManager.getSSID();
-    
+    Log.println("Starting...");
+
+    device.begin();
+
+    ConfigManager* configManager = portal.getConfigManager();
+    configManager->loadConfig();
+
+    device.onSettingsChange(onSettingsChange);
+    device.setApiKey(configManager->getApiKey());
+
+    const char* ssid = configManager->getSSID();
+    connection.onStateChange(onConnectionStateChange);
+    portal.onProvisioned(onProvisioned);
+
     if (strlen(ssid) == 0) {
-        Serial.println("No WiFi credentials found - starting captive portal");
+        Log.println("No WiFi credentials found - starting captive portal");
         portal.enterConfigMode();
     } else {
-        Serial.println("WiFi credentials found - connecting and exposing LED API");
+        Log.println("WiFi credentials found - connecting and exposing LED API");
         portal.begin();
+        connection.begin(ssid, configManager->getPassword(), &configManager->getNetworkCache());
     }
+
+    scheduler.addTask("sensor", SENSOR_PERIOD_MS, []() { device.sample(); });
+    scheduler.addTask("http", HTTP_PERIOD_MS, []() { device.updateAPIServer(); });
+    scheduler.addTask("mdns", MDNS_PERIOD_MS, []() { device.updateMDNS(); });
+    scheduler.addTask("wifi", WIFI_PERIOD_MS, []() { connection.update(); });
+    scheduler.addTask("portal", PORTAL_PERIOD_MS, []() { portal.update(); });
 }
 
 void loop() {
-    portal.update();
+    scheduler.run();
 }
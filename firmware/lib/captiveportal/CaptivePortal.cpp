@@ -1,133 +1,397 @@
 #include "CaptivePortal.h"
+#include "Log.h"
+#include "PortalAssets.h"
 
 namespace lovi {
 
 const char* AP_SSID = "Lovi-Config";
-const char* HTML_FORM = R"(
-<!DOCTYPE html>
-<html>
-<head>
-    <meta name="viewport" content="width=device-width, initial-scale=1">
-    <title>Lovi Device Configuration</title>
-    <style>
-        body { font-family: Arial; margin: 20px; }
-        input { margin: 10px 0; padding: 10px; width: 100%%; }
-        button { padding: 10px 20px; background: #007bff; color: white; border: none; }
-    </style>
-</head>
-<body>
-    <h1>Lovi Device Setup</h1>
-    <form method="POST" action="/save">
-        <label>WiFi SSID:</label>
-        <input type="text" name="ssid" required>
-        <label>WiFi Password:</label>
-        <input type="password" name="password" required>
-        <button type="submit">Save & Connect</button>
-    </form>
-</body>
-</html>
-)";
+static const char* ASSET_CACHE_CONTROL = "max-age=86400";
+
+// Probe URLs the major OSes fetch to detect a captive portal. Answering
+// them with the portal page directly avoids a redirect round trip.
+static const char* const CONNECTIVITY_CHECKS[] = {
+    "/generate_204",
+    "/gen_204",
+    "/hotspot-detect.html",
+    "/library/test/success.html",
+    "/connecttest.txt",
+    "/ncsi.txt",
+    "/redirect",
+    "/canonical.html",
+    "/success.txt",
+};
+
+static const char* _provisionStateString(ProvisionState state) {
+    switch (state) {
+        case ProvisionState::CONNECTING:
+            return "connecting";
+        case ProvisionState::CONNECTED:
+            return "connected";
+        case ProvisionState::FAILED:
+            return "failed";
+        default:
+            return "idle";
+    }
+}
+
+static void _copyArg(char* destination, size_t size, const String& value) {
+    strncpy(destination, value.c_str(), size - 1);
+    destination[size - 1] = '\0';
+}
 
 CaptivePortal::CaptivePortal(uint8_t ledPin)
-    : _configManager(nullptr)
-    , _ledController(nullptr)
-    , _ledPin(ledPin)
-    , _configMode(false)
-    , _started(false)
-    , _dnsServer(nullptr)
-    , _webServer(nullptr) {
+    : _ledController(ledPin)
+    , _state(PortalState::IDLE)
+    , _configLoaded(false)
+    , _routesRegistered(false)
+    , _webServer(80)
+    , _scanCount(0)
+    , _scanRunning(false)
+    , _scanValid(false)
+    , _scanTimeMs(0)
+    , _provisionState(ProvisionState::IDLE)
+    , _provisionError(nullptr)
+    , _provisionSinceMs(0)
+    , _provisionIp(0) {
+    memset(&_pending, 0, sizeof(_pending));
 }
 
 CaptivePortal::~CaptivePortal() {
-    if (_dnsServer) delete _dnsServer;
-    if (_webServer) delete _webServer;
-    if (_configManager) delete _configManager;
-    if (_ledController) delete _ledController;
+    if (_state == PortalState::CONFIG) {
+        _dnsServer.stop();
+        _webServer.stop();
+    }
 }
 
 void CaptivePortal::begin() {
-    if (_started) return;
-    
-    _configManager = new ConfigManager();
-    _configManager->begin();
-    _configManager->loadConfig();
-    
-    _ledController = new LEDController(_ledPin);
-    _ledController->begin();
-    
-    _setupWebServer();
-    _started = true;
+    if (_state != PortalState::IDLE) return;
+
+    _initialize();
+    _state = PortalState::STATION;
 }
 
 void CaptivePortal::enterConfigMode() {
-    if (_configMode) return;
-    
-    _configMode = true;
-    _configManager = new ConfigManager();
-    _ledController = new LEDController(_ledPin);
-    _ledController->begin();
-    
+    if (_state == PortalState::CONFIG) return;
+
+    _initialize();
+    _state = PortalState::CONFIG;
+
     _setupAP();
     _setupWebServer();
-    
-    _dnsServer = new DNSServer();
-    _dnsServer->start(53, "*", WiFi.softAPIP());
+
+    _dnsServer.start(53, "*", WiFi.softAPIP());
+    // Have the network list ready by the time the page asks for it.
+    _startScan();
 }
 
 void CaptivePortal::update() {
-    if (_configMode && _dnsServer) {
-        _dnsServer->processNextRequest();
-    }
-    if (_webServer) {
-        _webServer->handleClient();
+    if (_state == PortalState::CONFIG) {
+        _dnsServer.processNextRequest();
+        _webServer.handleClient();
+        _updateScan();
+        _updateProvisioning();
     }
 }
 
 bool CaptivePortal::isInConfigMode() const {
-    return _configMode;
+    return _state == PortalState::CONFIG;
+}
+
+void CaptivePortal::_initialize() {
+    if (!_configLoaded) {
+        _configManager.begin();
+        _configLoaded = true;
+    }
+    if (_state == PortalState::IDLE) {
+        _ledController.begin();
+    }
 }
 
 void CaptivePortal::_setupAP() {
-    WiFi.mode(WIFI_AP);
+    // Credentials are persisted by ConfigManager, not by the SDK.
+    WiFi.persistent(false);
+    WiFi.disconnect();
+    WiFi.mode(WIFI_AP_STA);
     WiFi.softAP(AP_SSID);
-    Serial.print("Access Point IP: ");
-    Serial.println(WiFi.softAPIP());
+    Log.print("Access Point IP: ");
+    Log.println(WiFi.softAPIP());
 }
 
 void CaptivePortal::_setupWebServer() {
-    _webServer = new ESP8266WebServer(80);
-    
-    _webServer->on("/", [this]() { _handleRoot(); });
-    _webServer->on("/save", [this]() { _handleSave(); });
-    _webServer->onNotFound([this]() { _handleNotFound(); });
-    
-    _webServer->begin();
+    if (!_routesRegistered) {
+        for (size_t i = 0; i < PORTAL_ASSET_COUNT; i++) {
+            const PortalAsset* asset = &PORTAL_ASSETS[i];
+            _webServer.on(asset->path, HTTP_GET, [this, asset]() { _sendAsset(asset); });
+        }
+        for (const char* path : CONNECTIVITY_CHECKS) {
+            _webServer.on(path, HTTP_GET, [this]() { _handleRoot(); });
+        }
+        _webServer.on("/save", [this]() { _handleSave(); });
+        _webServer.on("/status", HTTP_GET, [this]() { _handleStatus(); });
+        _webServer.on("/scan", HTTP_GET, [this]() { _handleScan(); });
+        _webServer.onNotFound([this]() { _handleNotFound(); });
+        _routesRegistered = true;
+    }
+
+    _webServer.begin();
 }
 
 void CaptivePortal::_handleRoot() {
-    _webServer->send(200, "text/html", HTML_FORM);
+    for (size_t i = 0; i < PORTAL_ASSET_COUNT; i++) {
+        if (strcmp(PORTAL_ASSETS[i].path, "/") == 0) {
+            _sendAsset(&PORTAL_ASSETS[i]);
+            return;
+        }
+    }
+    _handleNotFound();
+}
+
+void CaptivePortal::_sendAsset(const PortalAsset* asset) {
+    _webServer.sendHeader("Content-Encoding", "gzip");
+    _webServer.sendHeader("Cache-Control", ASSET_CACHE_CONTROL);
+    _webServer.send_P(200, asset->contentType, reinterpret_cast<PGM_P>(asset->data), asset->length);
 }
 
 void CaptivePortal::_handleSave() {
-    if (_webServer->hasArg("ssid") && _webServer->hasArg("password")) {
-        String ssid = _webServer->arg("ssid");
-        String password = _webServer->arg("password");
-        
-        _configManager->setSSID(ssid.c_str());
-        _configManager->setPassword(password.c_str());
-        _configManager->saveConfig();
-        
-        _webServer->send(200, "text/html", "<h1>Settings Saved!</h1><p>Device will restart.</p>");
-        delay(1000);
-        ESP.restart();
+    if (!_webServer.hasArg("ssid") || !_webServer.hasArg("password")) {
+        _webServer.send(400, "application/json", "{\"error\":\"Missing ssid or password\"}");
+        return;
+    }
+
+    const String ssid = _webServer.arg("ssid");
+    const String password = _webServer.arg("password");
+    if (ssid.length() == 0 || ssid.length() >= sizeof(_pending.ssid)
+        || password.length() >= sizeof(_pending.password)) {
+        _webServer.send(400, "application/json", "{\"error\":\"Invalid ssid or password\"}");
+        return;
+    }
+    if (_provisionState == ProvisionState::CONNECTED) {
+        _webServer.send(409, "application/json", "{\"error\":\"Already connected\"}");
+        return;
+    }
+
+    _copyArg(_pending.ssid, sizeof(_pending.ssid), ssid);
+    _copyArg(_pending.password, sizeof(_pending.password), password);
+    _copyArg(_pending.apiKey, sizeof(_pending.apiKey),
+             _webServer.hasArg("api_key") ? _webServer.arg("api_key") : String());
+
+    // A scan would hold the radio off-channel during the attempt.
+    _scanRunning = false;
+    WiFi.scanDelete();
+
+    Log.print("Trying WiFi credentials for ");
+    Log.println(_pending.ssid);
+    WiFi.disconnect();
+    WiFi.begin(_pending.ssid, _pending.password);
+    _provisionState = ProvisionState::CONNECTING;
+    _provisionError = nullptr;
+    _provisionSinceMs = millis();
+
+    _webServer.send(202, "application/json", "{\"state\":\"connecting\"}");
+}
+
+void CaptivePortal::_handleStatus() {
+    char json[128];
+    int length;
+    if (_provisionState == ProvisionState::CONNECTED) {
+        length = snprintf(json, sizeof(json), "{\"state\":\"%s\",\"error\":null,\"ip\":\"%u.%u.%u.%u\"}",
+                          _provisionStateString(_provisionState),
+                          static_cast<unsigned>(_provisionIp & 0xFF),
+                          static_cast<unsigned>((_provisionIp >> 8) & 0xFF),
+                          static_cast<unsigned>((_provisionIp >> 16) & 0xFF),
+                          static_cast<unsigned>(_provisionIp >> 24));
+    } else if (_provisionError) {
+        length = snprintf(json, sizeof(json), "{\"state\":\"%s\",\"error\":\"%s\",\"ip\":null}",
+                          _provisionStateString(_provisionState), _provisionError);
     } else {
-        _webServer->send(400, "text/html", "<h1>Invalid Request</h1>");
+        length = snprintf(json, sizeof(json), "{\"state\":\"%s\",\"error\":null,\"ip\":null}",
+                          _provisionStateString(_provisionState));
+    }
+
+    _webServer.sendHeader("Cache-Control", "no-store");
+    _webServer.send(200, "application/json", json, length);
+}
+
+void CaptivePortal::_handleScan() {
+    if (!_scanValid || millis() - _scanTimeMs >= SCAN_CACHE_MS) {
+        _startScan();
+    }
+
+    _webServer.sendHeader("Cache-Control", "no-store");
+    _webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _webServer.send(200, "application/json", "");
+
+    char chunk[48];
+    snprintf(chunk, sizeof(chunk), "{\"scanning\":%s,\"networks\":[", _scanRunning ? "true" : "false");
+    _webServer.sendContent(chunk);
+    for (uint8_t i = 0; i < _scanCount; i++) {
+        _webServer.sendContent(i ? ",{\"ssid\":" : "{\"ssid\":");
+        _sendJsonString(_scanResults[i].ssid);
+        snprintf(chunk, sizeof(chunk), ",\"rssi\":%d,\"secure\":%s}",
+                 _scanResults[i].rssi, _scanResults[i].secure ? "true" : "false");
+        _webServer.sendContent(chunk);
+    }
+    _webServer.sendContent("]}");
+    _webServer.sendContent("");
+}
+
+void CaptivePortal::_startScan() {
+    if (_scanRunning || _provisionState == ProvisionState::CONNECTING) {
+        return;
+    }
+    WiFi.scanNetworks(true, false);
+    _scanRunning = true;
+}
+
+void CaptivePortal::_updateScan() {
+    if (!_scanRunning) {
+        return;
+    }
+
+    int8_t found = WiFi.scanComplete();
+    if (found == WIFI_SCAN_RUNNING) {
+        return;
+    }
+    _scanRunning = false;
+    if (found < 0) {
+        return;
+    }
+
+    // Strongest first, one entry per SSID; hidden networks are left out.
+    _scanCount = 0;
+    for (int8_t i = 0; i < found; i++) {
+        const String ssid = WiFi.SSID(i);
+        int8_t rssi = static_cast<int8_t>(WiFi.RSSI(i));
+        if (ssid.length() == 0 || ssid.length() >= sizeof(_scanResults[0].ssid)) {
+            continue;
+        }
+
+        uint8_t slot = 0;
+        while (slot < _scanCount && strcmp(_scanResults[slot].ssid, ssid.c_str()) != 0) {
+            slot++;
+        }
+        if (slot < _scanCount) {
+            if (_scanResults[slot].rssi >= rssi) {
+                continue;
+            }
+        } else if (_scanCount < MAX_SCAN_RESULTS) {
+            slot = _scanCount++;
+        } else if (_scanResults[_scanCount - 1].rssi < rssi) {
+            slot = _scanCount - 1;
+        } else {
+            continue;
+        }
+
+        ScanResult result;
+        _copyArg(result.ssid, sizeof(result.ssid), ssid);
+        result.rssi = rssi;
+        result.secure = WiFi.encryptionType(i) != ENC_TYPE_NONE;
+        while (slot > 0 && _scanResults[slot - 1].rssi < rssi) {
+            _scanResults[slot] = _scanResults[slot - 1];
+            slot--;
+        }
+        _scanResults[slot] = result;
+    }
+    WiFi.scanDelete();
+
+    _scanValid = true;
+    _scanTimeMs = millis();
+}
+
+void CaptivePortal::_updateProvisioning() {
+    if (_provisionState == ProvisionState::CONNECTED) {
+        if (millis() - _provisionSinceMs >= HANDOVER_DELAY_MS) {
+            _handover();
+        }
+        return;
+    }
+    if (_provisionState != ProvisionState::CONNECTING) {
+        return;
+    }
+
+    switch (WiFi.status()) {
+        case WL_CONNECTED:
+            break;
+        case WL_WRONG_PASSWORD:
+            _failProvisioning("wrong_password");
+            return;
+        case WL_NO_SSID_AVAIL:
+            _failProvisioning("network_not_found");
+            return;
+        case WL_CONNECT_FAILED:
+            _failProvisioning("connect_failed");
+            return;
+        default:
+            if (millis() - _provisionSinceMs >= PROVISION_TIMEOUT_MS) {
+                _failProvisioning("timeout");
+            }
+            return;
+    }
+
+    _provisionIp = WiFi.localIP();
+    Log.print("Provisioned, IP: ");
+    Log.println(WiFi.localIP());
+
+    _configManager.setSSID(_pending.ssid);
+    _configManager.setPassword(_pending.password);
+    if (_pending.apiKey[0]) {
+        _configManager.setApiKey(_pending.apiKey);
+    }
+    // Whatever was cached belongs to the previous network.
+    _configManager.setNetworkCache(NetworkCache());
+    _configManager.saveConfig();
+    memset(&_pending, 0, sizeof(_pending));
+
+    _provisionState = ProvisionState::CONNECTED;
+    _provisionSinceMs = millis();
+}
+
+void CaptivePortal::_failProvisioning(const char* error) {
+    Log.print("WiFi credentials rejected: ");
+    Log.println(error);
+    WiFi.disconnect();
+    memset(&_pending, 0, sizeof(_pending));
+    _provisionState = ProvisionState::FAILED;
+    _provisionError = error;
+}
+
+void CaptivePortal::_handover() {
+    Log.println("Leaving config mode");
+    _dnsServer.stop();
+    _webServer.stop();
+    // Drops the AP only; the station stays associated.
+    WiFi.softAPdisconnect(true);
+    _state = PortalState::STATION;
+    _provisionState = ProvisionState::IDLE;
+
+    if (_provisionedCallback) {
+        _provisionedCallback();
+    }
+}
+
+void CaptivePortal::_sendJsonString(const char* text) {
+    // Worst case every byte of the SSID needs a \u00XX escape.
+    char escaped[2 + sizeof(ScanResult::ssid) * 6 + 1];
+    size_t length = 0;
+    escaped[length++] = '"';
+    for (const char* c = text; *c && length < sizeof(escaped) - 8; c++) {
+        uint8_t byte = static_cast<uint8_t>(*c);
+        if (byte == '"' || byte == '\\') {
+            escaped[length++] = '\\';
+            escaped[length++] = static_cast<char>(byte);
+        } else if (byte < 0x20) {
+            length += snprintf(escaped + length, sizeof(escaped) - length, "\\u%04x", byte);
+        } else {
+            escaped[length++] = static_cast<char>(byte);
+        }
     }
+    escaped[length++] = '"';
+    _webServer.sendContent(escaped, length);
 }
 
 void CaptivePortal::_handleNotFound() {
-    _webServer->sendHeader("Location", "/");
-    _webServer->send(302);
+    _webServer.sendHeader("Location", "/");
+    _webServer.send(302);
 }
 
 }
@@ -4,13 +4,41 @@
 #include <ESP8266WiFi.h>
 #include <DNSServer.h>
 #include <ESP8266WebServer.h>
+#include <functional>
 #include "ConfigManager.h"
 #include "LEDController.h"
 
 namespace lovi {
 
+struct PortalAsset;
+
+enum class PortalState : uint8_t {
+    IDLE,
+    STATION,
+    CONFIG
+};
+
+enum class ProvisionState : uint8_t {
+    IDLE,
+    CONNECTING,
+    CONNECTED,
+    FAILED
+};
+
+// Config mode runs the AP and the station side together: submitted
+// credentials are tried in the background while the page polls /status,
+// and only saved once they work. On success the AP is shut down and the
+// radio stays associated, so no reboot is needed.
 class CaptivePortal {
 public:
+    typedef std::function<void()> ProvisionedCallback;
+
+    static const uint32_t PROVISION_TIMEOUT_MS = 20000;
+    // Keeps the AP up long enough for the page to show the new address.
+    static const uint32_t HANDOVER_DELAY_MS = 5000;
+    static const uint32_t SCAN_CACHE_MS = 30000;
+    static const uint8_t MAX_SCAN_RESULTS = 16;
+
     CaptivePortal(uint8_t ledPin);
     ~CaptivePortal();
 
@@ -19,23 +47,67 @@ public:
     void update();
 
     bool isInConfigMode() const;
-    ConfigManager* getConfigManager() { return _configManager; }
+    PortalState getState() const { return _state; }
+    ProvisionState getProvisionState() const { return _provisionState; }
+    ConfigManager* getConfigManager() { return &_configManager; }
+    LEDController* getLEDController() { return &_ledController; }
+
+    // Called after the portal has handed over to station mode; the saved
+    // credentials are already associated.
+    void onProvisioned(ProvisionedCallback callback) { _provisionedCallback = callback; }
 
 private:
-    ConfigManager* _configManager;
-    LEDController* _ledController;
-    uint8_t _ledPin;
-    
-    bool _configMode;
-    bool _started;
-    DNSServer* _dnsServer;
-    ESP8266WebServer* _webServer;
-    
+    // Sized like ConfigManager's fields, so anything listed can be saved.
+    struct ScanResult {
+        char ssid[32];
+        int8_t rssi;
+        bool secure;
+    };
+
+    struct Credentials {
+        char ssid[32];
+        char password[64];
+        char apiKey[48];
+    };
+
+    ConfigManager _configManager;
+    LEDController _ledController;
+
+    PortalState _state;
+    bool _configLoaded;
+    bool _routesRegistered;
+    DNSServer _dnsServer;
+    ESP8266WebServer _webServer;
+
+    ScanResult _scanResults[MAX_SCAN_RESULTS];
+    uint8_t _scanCount;
+    bool _scanRunning;
+    bool _scanValid;
+    uint32_t _scanTimeMs;
+
+    ProvisionState _provisionState;
+    Credentials _pending;
+    const char* _provisionError;
+    uint32_t _provisionSinceMs;
+    uint32_t _provisionIp;
+    ProvisionedCallback _provisionedCallback;
+
+    void _initialize();
     void _setupAP();
     void _setupWebServer();
     void _handleRoot();
+    void _sendAsset(const PortalAsset* asset);
     void _handleSave();
+    void _handleStatus();
+    void _handleScan();
     void _handleNotFound();
+
+    void _startScan();
+    void _updateScan();
+    void _updateProvisioning();
+    void _failProvisioning(const char* error);
+    void _handover();
+    void _sendJsonString(const char* text);
 };
 
 }
@@ -1,10 +1,31 @@
 #include "ConfigManager.h"
+#include "Log.h"
+#include <coredecls.h>
+#include <spi_flash.h>
+
+extern "C" uint32_t _EEPROM_start;
 
 namespace lovi {
 
-ConfigManager::ConfigManager() {
-    _ssid[0] = '\0';
-    _password[0] = '\0';
+static const uint32_t CONFIG_SECTOR = ((uintptr_t)&_EEPROM_start - 0x40200000) / SPI_FLASH_SEC_SIZE;
+static const size_t TOTAL_SLOTS = ConfigManager::SLOT_COUNT * ConfigManager::SECTOR_COUNT;
+
+// Slots 0..SLOT_COUNT-1 live in the EEPROM sector, the rest in the sectors below it.
+static uint32_t _sectorOf(uint8_t slot) {
+    return CONFIG_SECTOR - slot / ConfigManager::SLOT_COUNT;
+}
+
+static uint32_t _slotAddress(uint8_t slot) {
+    return _sectorOf(slot) * SPI_FLASH_SEC_SIZE + (slot % ConfigManager::SLOT_COUNT) * ConfigManager::SLOT_SIZE;
+}
+
+static bool _isTerminated(const char* text, size_t size) {
+    return memchr(text, '\0', size) != nullptr;
+}
+
+ConfigManager::ConfigManager() : _sequence(0), _slot(-1) {
+    _resetPayload(_payload);
+    _resetPayload(_stored);
 }
 
 void ConfigManager::begin() {
@@ -12,58 +33,228 @@ void ConfigManager::begin() {
 }
 
 void ConfigManager::loadConfig() {
-    _loadFromEEPROM();
+    _loadFromFlash();
 }
 
 void ConfigManager::saveConfig() {
-    _saveToEEPROM();
+    _saveToFlash();
 }
 
 const char* ConfigManager::getSSID() const {
-    return _ssid;
+    return _payload.ssid;
 }
 
 const char* ConfigManager::getPassword() const {
-    return _password;
+    return _payload.password;
+}
+
+const char* ConfigManager::getApiKey() const {
+    return _payload.apiKey;
+}
+
+void ConfigManager::setApiKey(const char* apiKey) {
+    strncpy(_payload.apiKey, apiKey, sizeof(_payload.apiKey) - 1);
+    _payload.apiKey[sizeof(_payload.apiKey) - 1] = '\0';
+}
+
+uint8_t ConfigManager::getSensitivity() const {
+    return _payload.sensitivity;
+}
+
+void ConfigManager::setSensitivity(uint8_t sensitivity) {
+    _payload.sensitivity = sensitivity > 100 ? 100 : sensitivity;
+}
+
+bool ConfigManager::getBroadcast() const {
+    return _payload.flags & FLAG_BROADCAST;
+}
+
+void ConfigManager::setBroadcast(bool enabled) {
+    if (enabled) {
+        _payload.flags |= FLAG_BROADCAST;
+    } else {
+        _payload.flags &= ~FLAG_BROADCAST;
+    }
+}
+
+const NetworkCache& ConfigManager::getNetworkCache() const {
+    return _payload.networkCache;
+}
+
+bool ConfigManager::setNetworkCache(const NetworkCache& cache) {
+    const NetworkCache& current = _payload.networkCache;
+    if (cache.valid == current.valid
+        && memcmp(cache.bssid, current.bssid, sizeof(cache.bssid)) == 0
+        && cache.channel == current.channel
+        && cache.ip == current.ip
+        && cache.gateway == current.gateway
+        && cache.subnet == current.subnet
+        && cache.dns == current.dns) {
+        return false;
+    }
+    _payload.networkCache = cache;
+    return true;
 }
 
 void ConfigManager::setSSID(const char* ssid) {
-    strncpy(_ssid, ssid, sizeof(_ssid) - 1);
-    _ssid[sizeof(_ssid) - 1] = '\0';
+    strncpy(_payload.ssid, ssid, sizeof(_payload.ssid) - 1);
+    _payload.ssid[sizeof(_payload.ssid) - 1] = '\0';
 }
 
 void ConfigManager::setPassword(const char* password) {
-    strncpy(_password, password, sizeof(_password) - 1);
-    _password[sizeof(_password) - 1] = '\0';
+    strncpy(_payload.password, password, sizeof(_payload.password) - 1);
+    _payload.password[sizeof(_payload.password) - 1] = '\0';
 }
 
 bool ConfigManager::isConfigured() const {
-    return strlen(_ssid) > 0;
+    return strlen(_payload.ssid) > 0;
 }
 
 void ConfigManager::clearConfig() {
-    _ssid[0] = '\0';
-    _password[0] = '\0';
-    _saveToEEPROM();
+    _resetPayload(_payload);
+    _saveToFlash();
 }
 
-void ConfigManager::_loadFromEEPROM() {
-    for (size_t i = 0; i < sizeof(_ssid); i++) {
-        _ssid[i] = EEPROM.read(i);
+void ConfigManager::_resetPayload(Payload& payload) {
+    payload = Payload();
+    payload.sensitivity = 50;
+}
+
+bool ConfigManager::_readSlot(uint8_t slot, RecordHeader& header, Payload& payload) {
+    static_assert(sizeof(RecordHeader) + sizeof(Payload) <= SLOT_SIZE, "config record exceeds slot");
+    static_assert(SLOT_SIZE * SLOT_COUNT <= SPI_FLASH_SEC_SIZE, "config slots exceed sector");
+
+    // The whole slot, since newer firmware may store a longer payload.
+    alignas(4) uint8_t record[SLOT_SIZE];
+    if (!ESP.flashRead(_slotAddress(slot), reinterpret_cast<uint32_t*>(record), sizeof(record))) {
+        return false;
     }
-    for (size_t i = 0; i < sizeof(_password); i++) {
-        _password[i] = EEPROM.read(sizeof(_ssid) + i);
+
+    memcpy(&header, record, sizeof(header));
+    if (header.magic != RECORD_MAGIC || header.version == 0
+        || header.length == 0 || header.length > sizeof(record) - sizeof(header)) {
+        return false;
     }
+
+    const uint8_t* body = record + sizeof(header);
+    if (crc32(body, header.length) != header.crc) {
+        return false;
+    }
+
+    // Older records leave defaults; fields appended by newer firmware are skipped.
+    _resetPayload(payload);
+    memcpy(&payload, body, header.length < sizeof(payload) ? header.length : sizeof(payload));
+    payload.ssid[sizeof(payload.ssid) - 1] = '\0';
+    payload.password[sizeof(payload.password) - 1] = '\0';
+    payload.apiKey[sizeof(payload.apiKey) - 1] = '\0';
+    return true;
+}
+
+bool ConfigManager::_isErased(uint8_t slot) {
+    alignas(4) uint32_t record[(sizeof(RecordHeader) + sizeof(Payload) + 3) / 4];
+    if (!ESP.flashRead(_slotAddress(slot), record, sizeof(record))) {
+        return false;
+    }
+    for (uint32_t word : record) {
+        if (word != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
 }
 
-void ConfigManager::_saveToEEPROM() {
-    for (size_t i = 0; i < sizeof(_ssid); i++) {
-        EEPROM.write(i, _ssid[i]);
+// Pre-record firmware stored a raw SSID and password at offset 0.
+bool ConfigManager::_loadLegacy() {
+    alignas(4) char legacy[96];
+    if (!ESP.flashRead(_slotAddress(0), reinterpret_cast<uint32_t*>(legacy), sizeof(legacy))) {
+        return false;
     }
-    for (size_t i = 0; i < sizeof(_password); i++) {
-        EEPROM.write(sizeof(_ssid) + i, _password[i]);
+
+    const char* ssid = legacy;
+    const char* password = legacy + 32;
+    if (!_isTerminated(ssid, 32) || !_isTerminated(password, 64) || ssid[0] == '\0') {
+        return false;
     }
-    EEPROM.commit();
+    for (const char* c = ssid; *c; c++) {
+        if (*c < 0x20 || *c > 0x7E) {
+            return false;
+        }
+    }
+
+    setSSID(ssid);
+    setPassword(password);
+    return true;
+}
+
+void ConfigManager::_loadFromFlash() {
+    _resetPayload(_payload);
+    _sequence = 0;
+    _slot = -1;
+
+    RecordHeader header;
+    Payload payload;
+    for (uint8_t slot = 0; slot < TOTAL_SLOTS; slot++) {
+        if (_readSlot(slot, header, payload) && (_slot < 0 || header.sequence > _sequence)) {
+            _payload = payload;
+            _sequence = header.sequence;
+            _slot = slot;
+        }
+    }
+
+    if (_slot >= 0) {
+        _stored = _payload;
+    } else if (_loadLegacy()) {
+        Log.println("Migrating legacy config");
+        _saveToFlash();
+    }
+}
+
+void ConfigManager::_saveToFlash() {
+    if (_slot >= 0 && memcmp(&_payload, &_stored, sizeof(_payload)) == 0) {
+        return;
+    }
+
+    // The first record goes to the spare sector so a legacy config in
+    // the EEPROM sector outlives the migration write.
+    uint8_t slot = _slot < 0 ? SLOT_COUNT : (_slot + 1) % TOTAL_SLOTS;
+
+    // A sector is erased on entry; a used or torn slot moves saving on to
+    // the next sector, never erasing the one holding the newest record.
+    if (slot % SLOT_COUNT != 0 && !_isErased(slot)) {
+        slot = (slot / SLOT_COUNT + 1) % SECTOR_COUNT * SLOT_COUNT;
+    }
+    if (slot % SLOT_COUNT == 0 && !ESP.flashEraseSector(_sectorOf(slot))) {
+        Log.println("Config erase failed");
+        return;
+    }
+
+    alignas(4) uint8_t record[(sizeof(RecordHeader) + sizeof(Payload) + 3) & ~3];
+    memset(record, 0xFF, sizeof(record));
+
+    RecordHeader header;
+    header.magic = RECORD_MAGIC;
+    header.version = RECORD_VERSION;
+    header.length = sizeof(Payload);
+    header.sequence = _sequence + 1;
+    header.crc = crc32(&_payload, sizeof(_payload));
+    memcpy(record + sizeof(header), &_payload, sizeof(_payload));
+
+    // Body first, header last: a torn write leaves the magic erased.
+    uint32_t address = _slotAddress(slot);
+    if (!ESP.flashWrite(address + sizeof(header), reinterpret_cast<uint32_t*>(record + sizeof(header)),
+                        sizeof(record) - sizeof(header))) {
+        Log.println("Config write failed");
+        return;
+    }
+    memcpy(record, &header, sizeof(header));
+    if (!ESP.flashWrite(address, reinterpret_cast<uint32_t*>(record), sizeof(header))) {
+        Log.println("Config write failed");
+        return;
+    }
+
+    _stored = _payload;
+    _sequence = header.sequence;
+    _slot = slot;
 }
 
 }
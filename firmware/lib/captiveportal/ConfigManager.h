@@ -1,13 +1,24 @@
 #pragma once
 
 #include <Arduino.h>
-#include <EEPROM.h>
-#include "Device.h"
+#include "types.h"
 
 namespace lovi {
 
 class ConfigManager {
 public:
+    // Config records are appended in fixed slots across two flash sectors:
+    // the EEPROM sector and the spare one below it, which the 4 MB layouts
+    // leave between the filesystem and EEPROM. A sector is erased only when
+    // saving moves into it, so the newest record always survives until its
+    // successor is written.
+    static const uint32_t RECORD_MAGIC = 0x4C4F5649;  // "LOVI"
+    static const uint16_t RECORD_VERSION = 1;
+    static const size_t SLOT_SIZE = 256;
+    static const size_t SLOT_COUNT = 16;
+    static const size_t SECTOR_COUNT = 2;
+    static const uint8_t FLAG_BROADCAST = 0x01;
+
     ConfigManager();
     void begin();
     void loadConfig();
@@ -17,15 +28,51 @@ public:
     const char* getPassword() const;
     void setSSID(const char* ssid);
     void setPassword(const char* password);
+
+    const char* getApiKey() const;
+    void setApiKey(const char* apiKey);
+    uint8_t getSensitivity() const;
+    void setSensitivity(uint8_t sensitivity);
+    bool getBroadcast() const;
+    void setBroadcast(bool enabled);
+
+    const NetworkCache& getNetworkCache() const;
+    bool setNetworkCache(const NetworkCache& cache);
     
     bool isConfigured() const;
     void clearConfig();
 
 private:
-    char _ssid[32];
-    char _password[64];
-    void _loadFromEEPROM();
-    void _saveToEEPROM();
+    struct RecordHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t length;
+        uint32_t sequence;
+        uint32_t crc;
+    };
+
+    // Fields are only ever appended so older records stay readable.
+    struct Payload {
+        char ssid[32];
+        char password[64];
+        char apiKey[48];
+        uint8_t sensitivity;
+        uint8_t flags;
+        uint8_t reserved[2];
+        NetworkCache networkCache;
+    };
+
+    Payload _payload;
+    Payload _stored;
+    uint32_t _sequence;
+    int8_t _slot;
+
+    void _resetPayload(Payload& payload);
+    bool _readSlot(uint8_t slot, RecordHeader& header, Payload& payload);
+    bool _isErased(uint8_t slot);
+    bool _loadLegacy();
+    void _loadFromFlash();
+    void _saveToFlash();
 };
 
 }
@@ -0,0 +1,120 @@
+#pragma once
+
+// Generated by scripts/embed_assets.py from lib/captiveportal/assets.
+// Do not edit; change the source asset and rebuild.
+
+#include <Arduino.h>
+
+namespace lovi {
+
+struct PortalAsset {
+    const char* path;
+    const char* contentType;
+    const uint8_t* data;
+    size_t length;
+};
+
+static const uint8_t ASSET_INDEX_HTML[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xbd, 0x58, 0x5b, 0x6f, 0xdb, 0x36,
+    0x14, 0x7e, 0xcf, 0xaf, 0x38, 0x75, 0xb1, 0x49, 0x46, 0x63, 0xd9, 0x69, 0xb7, 0x75, 0xf5, 0x25,
+    0x45, 0x9b, 0x64, 0x6b, 0xb6, 0x5e, 0x82, 0xc6, 0x43, 0x37, 0x14, 0x45, 0x40, 0x8b, 0xb4, 0xcd,
+    0x95, 0x26, 0x35, 0x92, 0x8a, 0x63, 0xb4, 0xf9, 0xef, 0x3b, 0x24, 0x25, 0x5b, 0x56, 0xe4, 0x34,
+    0xdd, 0x86, 0xe9, 0xc5, 0x12, 0x79, 0xee, 0xfc, 0xce, 0x85, 0x1e, 0xde, 0x3b, 0x7e, 0x73, 0x34,
+    0xfe, 0xe3, 0xec, 0x04, 0xe6, 0x76, 0x21, 0x0e, 0xf7, 0x86, 0xe5, 0x0f, 0x23, 0xf4, 0x70, 0x0f,
+    0xf0, 0x19, 0x2e, 0x98, 0x25, 0x20, 0xc9, 0x82, 0x8d, 0x5a, 0x97, 0x9c, 0x2d, 0x33, 0xa5, 0x6d,
+    0x0b, 0x52, 0x25, 0x2d, 0x93, 0x76, 0xd4, 0x5a, 0x72, 0x6a, 0xe7, 0x23, 0xca, 0x2e, 0x79, 0xca,
+    0x3a, 0xfe, 0x63, 0x1f, 0xb8, 0xe4, 0x96, 0x13, 0xd1, 0x31, 0x29, 0x11, 0x6c, 0x74, 0xd0, 0x2a,
+    0x04, 0x59, 0x6e, 0x05, 0x3b, 0x7c, 0xa9, 0x2e, 0x39, 0x1c, 0x7b, 0x7a, 0x38, 0x52, 0x72, 0xca,
+    0x67, 0xb9, 0x26, 0x96, 0x2b, 0x39, 0xec, 0x06, 0x82, 0x40, 0x6c, 0xec, 0xaa, 0x7c, 0x77, 0xcf,
+    0x44, 0xd1, 0x15, 0x7c, 0x82, 0x29, 0xaa, 0xed, 0x4c, 0xc9, 0x82, 0x8b, 0x55, 0x1f, 0x9e, 0x69,
+    0x54, 0x32, 0x80, 0x05, 0xd1, 0x33, 0x2e, 0xfb, 0xf0, 0xb0, 0x97, 0x5d, 0x0d, 0xe0, 0x7a, 0xcd,
+    0xc2, 0x65, 0x96, 0x5b, 0xe4, 0x29, 0xf7, 0x0f, 0x70, 0x1f, 0x7a, 0x03, 0xc8, 0x08, 0xa5, 0x5c,
+    0xce, 0xc2, 0xc2, 0x00, 0xbc, 0xcd, 0xee, 0xa3, 0xf7, 0x4d, 0x95, 0x7b, 0x92, 0x5b, 0xab, 0x24,
+    0xb2, 0x6f, 0x91, 0x17, 0x4a, 0x26, 0x24, 0xfd, 0x38, 0xd3, 0x2a, 0x97, 0xb4, 0x0f, 0xf7, 0x7b,
+    0xbd, 0xc7, 0x93, 0xe9, 0x74, 0x80, 0x21, 0x11, 0x4a, 0xf7, 0x61, 0x39, 0xe7, 0x96, 0x21, 0x89,
+    0xd2, 0x94, 0xe1, 0xa7, 0x54, 0x92, 0xdd, 0x94, 0xdb, 0xa7, 0xdc, 0x90, 0x89, 0x60, 0x14, 0x15,
+    0x6c, 0x09, 0x7b, 0xf2, 0xe4, 0x49, 0x95, 0xfa, 0xbe, 0xb1, 0xc4, 0xe6, 0x66, 0xed, 0x45, 0xc7,
+    0xaa, 0x0c, 0x2d, 0xf9, 0x7e, 0xe3, 0xe9, 0xb0, 0x5b, 0x44, 0x6a, 0xd8, 0x0d, 0x67, 0x36, 0x74,
+    0xa1, 0x2a, 0x82, 0x38, 0x3f, 0xd8, 0x0a, 0xf7, 0x39, 0xb3, 0x79, 0x86, 0x74, 0x07, 0xc5, 0xf6,
+    0x54, 0xe9, 0x05, 0x70, 0x3a, 0x6a, 0x19, 0xb7, 0xd1, 0x02, 0x3c, 0xe9, 0xb9, 0xc2, 0xcf, 0xb3,
+    0x37, 0xe7, 0xe3, 0x16, 0x90, 0xd4, 0x9d, 0xca, 0xa8, 0xd5, 0x35, 0xe4, 0x92, 0xb5, 0x36, 0x47,
+    0x31, 0x14, 0x64, 0xc2, 0xc4, 0xe1, 0x3b, 0xfe, 0x13, 0x87, 0xf3, 0xf3, 0xd3, 0xe3, 0xfe, 0xb0,
+    0x1b, 0x56, 0x36, 0x14, 0x21, 0xf4, 0x76, 0x95, 0x21, 0x66, 0x2c, 0xbb, 0x42, 0xbc, 0x04, 0xfc,
+    0x18, 0xc3, 0x69, 0x0b, 0x04, 0x37, 0x08, 0x1c, 0xc9, 0xec, 0x52, 0xe9, 0x8f, 0x06, 0xd5, 0x92,
+    0x2b, 0xc1, 0xe4, 0x0c, 0x61, 0xd4, 0x7a, 0x74, 0xd0, 0x02, 0xcd, 0xfe, 0xca, 0xb9, 0x66, 0xb4,
+    0x22, 0x8f, 0x12, 0x4b, 0x1c, 0x97, 0x37, 0x76, 0xcd, 0x78, 0x38, 0xec, 0x96, 0x1b, 0xcd, 0xd6,
+    0x9d, 0x11, 0x63, 0x90, 0x94, 0x7e, 0xc1, 0xc2, 0xac, 0x20, 0x2b, 0xad, 0xdc, 0x7c, 0x57, 0x2c,
+    0xfb, 0xe1, 0xd1, 0xcd, 0x10, 0x3c, 0x3b, 0x3b, 0x85, 0x5f, 0xd9, 0x0a, 0x62, 0x95, 0xb9, 0x50,
+    0x11, 0xb1, 0x0f, 0x4c, 0xba, 0x63, 0x35, 0x30, 0xe5, 0x7a, 0xb1, 0x24, 0x9a, 0x41, 0x9e, 0xa1,
+    0x8d, 0xcc, 0xb4, 0xbf, 0xd2, 0x06, 0x92, 0xf1, 0x8b, 0x8f, 0x6c, 0x85, 0x26, 0x70, 0x59, 0x9a,
+    0xf0, 0xe3, 0x96, 0x41, 0xdf, 0x3d, 0xae, 0x1a, 0x54, 0xc0, 0x35, 0x08, 0x33, 0xf9, 0x64, 0xc1,
+    0x6d, 0xeb, 0xf0, 0x1c, 0x0f, 0x0e, 0xbe, 0x75, 0x59, 0x26, 0x59, 0x6a, 0x87, 0xdd, 0x40, 0x54,
+    0x1c, 0x7e, 0xd7, 0x9d, 0x7e, 0xf1, 0x9e, 0x05, 0x14, 0x78, 0xac, 0xb9, 0xb0, 0x66, 0x65, 0x12,
+    0xa6, 0x9a, 0x67, 0x95, 0xe0, 0x5e, 0x12, 0x0d, 0x1e, 0x34, 0x23, 0xa0, 0x2a, 0xcd, 0x17, 0x58,
+    0x01, 0x92, 0x19, 0xb3, 0x27, 0x82, 0xb9, 0xd7, 0xe7, 0xab, 0x53, 0x1a, 0x47, 0x1e, 0x4b, 0x51,
+    0x7b, 0xb0, 0xc5, 0xb4, 0x60, 0xc6, 0x90, 0x19, 0xbb, 0x95, 0xcf, 0x6b, 0xaf, 0x33, 0x32, 0xad,
+    0x95, 0x36, 0xc8, 0xf7, 0x69, 0xbd, 0xec, 0x9e, 0xa5, 0x56, 0x72, 0x76, 0x51, 0x06, 0xad, 0x0f,
+    0xd1, 0x3b, 0xb7, 0x00, 0xe5, 0x42, 0x12, 0xed, 0x6f, 0x91, 0x17, 0x90, 0xb9, 0x90, 0xca, 0x5e,
+    0x4c, 0x43, 0xa6, 0x45, 0xaf, 0xc3, 0x1a, 0x26, 0xa8, 0x05, 0xbf, 0x56, 0x67, 0x4a, 0x43, 0xd8,
+    0x2e, 0xa6, 0x84, 0x63, 0xa2, 0x22, 0xc7, 0x91, 0xca, 0x05, 0xf5, 0xf4, 0xc5, 0x56, 0x9d, 0xc3,
+    0xf2, 0x05, 0x53, 0xb9, 0x45, 0xd2, 0x31, 0xbe, 0x51, 0xc0, 0xf7, 0x92, 0x14, 0x2b, 0x48, 0x12,
+    0xad, 0x89, 0xaf, 0x07, 0x7b, 0xeb, 0xf7, 0x69, 0x2e, 0x7d, 0xa2, 0x01, 0x06, 0x24, 0xce, 0x88,
+    0xab, 0x9f, 0x14, 0x6b, 0x46, 0xbb, 0xe6, 0xb1, 0x0b, 0xc6, 0xd5, 0x5c, 0x63, 0x24, 0x24, 0x5b,
+    0xc2, 0xef, 0xaf, 0x5e, 0xbe, 0xb0, 0x36, 0x7b, 0x8b, 0xa9, 0xc2, 0x8c, 0x8d, 0x2b, 0x41, 0x73,
+    0x0f, 0xd2, 0x25, 0x2a, 0x63, 0x32, 0x8e, 0x7e, 0x3e, 0x19, 0x47, 0xfb, 0xe0, 0xa4, 0x36, 0x91,
+    0x48, 0xa1, 0x08, 0x45, 0x89, 0x6b, 0x13, 0x62, 0xd4, 0xea, 0xb5, 0xc7, 0x6e, 0xbf, 0xa8, 0x3d,
+    0xa3, 0x11, 0x56, 0xbd, 0x1e, 0x3c, 0x85, 0x5f, 0xce, 0xdf, 0xbc, 0x4e, 0x32, 0xa2, 0x4d, 0xd8,
+    0xd6, 0xcc, 0x64, 0x4a, 0x1a, 0x36, 0xc6, 0x04, 0x6f, 0x03, 0x56, 0xba, 0x5c, 0x88, 0xf6, 0xc0,
+    0xf9, 0x76, 0x53, 0x91, 0x3f, 0xc6, 0x66, 0x4d, 0xbb, 0xd9, 0x0c, 0x93, 0xb4, 0xea, 0xda, 0x75,
+    0x43, 0xd0, 0xb0, 0xc5, 0xc8, 0xb8, 0x1e, 0x2b, 0x17, 0xc9, 0xa8, 0xeb, 0xb6, 0xd0, 0xf9, 0x8d,
+    0x4a, 0x34, 0x38, 0x17, 0xb6, 0x4e, 0xec, 0x5b, 0xc5, 0x14, 0xe2, 0x7b, 0xe5, 0xb6, 0x46, 0x00,
+    0x6b, 0x39, 0xb8, 0x41, 0xe4, 0x4e, 0xc0, 0x17, 0xa1, 0x5b, 0x40, 0x5c, 0xd6, 0xa6, 0xa8, 0x7d,
+    0x93, 0xdf, 0xf1, 0x26, 0x1c, 0xd1, 0xa0, 0x5f, 0x8c, 0x5f, 0xbd, 0x44, 0x29, 0x51, 0x74, 0x93,
+    0x28, 0x18, 0x91, 0x94, 0x72, 0x12, 0xcc, 0xb6, 0x13, 0x92, 0xce, 0xe3, 0x8d, 0x17, 0xc5, 0x56,
+    0x93, 0x1b, 0xa5, 0x95, 0xa1, 0x1c, 0x55, 0xed, 0x4c, 0x35, 0xc3, 0x2a, 0x54, 0x98, 0x1a, 0x47,
+    0x81, 0xa0, 0xc9, 0x48, 0xf7, 0x84, 0xdd, 0xe4, 0x92, 0x88, 0x9c, 0x79, 0xbc, 0x79, 0x85, 0x89,
+    0x2b, 0xde, 0xb7, 0x32, 0xf8, 0xfa, 0x56, 0x61, 0xd0, 0xc8, 0x01, 0x0f, 0x20, 0x02, 0xfa, 0x7c,
+    0x11, 0xe1, 0x4b, 0xbc, 0x96, 0xc4, 0xd2, 0x1c, 0x4b, 0xe3, 0x53, 0x8c, 0x00, 0xe2, 0x06, 0xcf,
+    0xc8, 0x81, 0x75, 0x97, 0x35, 0x3e, 0x6c, 0x24, 0x43, 0x0a, 0x7a, 0x34, 0xe7, 0x82, 0x16, 0xc5,
+    0xb6, 0x81, 0xfa, 0xba, 0x61, 0xcd, 0x9d, 0x6c, 0x11, 0x53, 0x87, 0x07, 0x89, 0x79, 0xd8, 0x06,
+    0x2c, 0x51, 0xe3, 0x90, 0xaa, 0xb1, 0x5b, 0xdc, 0x77, 0xf8, 0xee, 0xd5, 0x98, 0xaf, 0xbf, 0x00,
+    0xbc, 0x4c, 0x09, 0xb1, 0x0b, 0x78, 0xa1, 0x92, 0xdd, 0x0d, 0x7a, 0xdd, 0x2e, 0x8c, 0xe7, 0x0c,
+    0x9e, 0x9d, 0x01, 0x5a, 0x02, 0x54, 0xab, 0x0c, 0x26, 0x9a, 0xb3, 0xa9, 0x58, 0xb9, 0x49, 0x42,
+    0x30, 0xb0, 0xb8, 0xab, 0x09, 0xe5, 0x0a, 0xd2, 0x39, 0x91, 0x33, 0xec, 0x2d, 0xee, 0x57, 0x32,
+    0x91, 0xdc, 0x06, 0x63, 0xf8, 0xfc, 0xb9, 0xc4, 0x92, 0x33, 0x87, 0xb9, 0x2c, 0x8e, 0x36, 0xb5,
+    0x28, 0xda, 0x05, 0x9f, 0x4a, 0x68, 0x9c, 0x87, 0xfb, 0x6e, 0x2e, 0xea, 0x35, 0xc5, 0x1a, 0x98,
+    0x30, 0x6c, 0x2b, 0xbc, 0x75, 0x35, 0x8c, 0xee, 0xd4, 0x52, 0xb4, 0x83, 0xc4, 0xcd, 0x06, 0x47,
+    0x61, 0x92, 0x74, 0xf9, 0x70, 0x54, 0x32, 0xde, 0xf3, 0x31, 0x09, 0x43, 0x25, 0x70, 0x83, 0x35,
+    0x77, 0x09, 0xc4, 0x82, 0x03, 0x51, 0xa1, 0x8d, 0x67, 0x8d, 0x82, 0xdd, 0xe3, 0x10, 0x87, 0x31,
+    0x5f, 0xa9, 0x5c, 0x97, 0x50, 0x04, 0x22, 0x29, 0x06, 0x12, 0x25, 0xf9, 0xee, 0xb4, 0x5e, 0x5e,
+    0x72, 0x21, 0x20, 0x15, 0xca, 0xb0, 0x24, 0xda, 0xe9, 0xe3, 0xd7, 0xb8, 0x10, 0x87, 0x7e, 0xf5,
+    0xbe, 0xb0, 0xd2, 0x7f, 0x7d, 0x70, 0x67, 0x51, 0xfa, 0xe6, 0xd0, 0x10, 0x1a, 0x4a, 0x82, 0xd1,
+    0x71, 0xa6, 0x9e, 0x09, 0x46, 0x50, 0x8b, 0xd5, 0x2b, 0x20, 0x33, 0xc2, 0x65, 0x93, 0x25, 0x1e,
+    0x79, 0xd8, 0x77, 0x13, 0x2c, 0xf7, 0x7a, 0x75, 0xce, 0x04, 0x4a, 0x52, 0x3a, 0x8e, 0x42, 0x43,
+    0x8f, 0xda, 0xc9, 0x7a, 0x9c, 0xc4, 0x12, 0x4b, 0xd0, 0xe8, 0x06, 0x67, 0xee, 0x84, 0x6e, 0xa7,
+    0x03, 0x6b, 0xba, 0x9f, 0x1f, 0xb6, 0xca, 0x35, 0xbb, 0x44, 0x07, 0xeb, 0xc7, 0xe9, 0x17, 0x93,
+    0x4c, 0xfb, 0xdf, 0x63, 0x36, 0x25, 0xe8, 0x73, 0xbd, 0x17, 0xfd, 0xb3, 0xbe, 0xe5, 0x26, 0x50,
+    0x4c, 0xa0, 0xc8, 0xcf, 0x9e, 0x51, 0xbb, 0xa9, 0x37, 0xd8, 0x42, 0xc8, 0x0b, 0x9c, 0x7a, 0x19,
+    0xc6, 0xa2, 0x38, 0x84, 0xce, 0x18, 0x47, 0x20, 0xc7, 0x8a, 0x25, 0x43, 0xf0, 0xd4, 0xdf, 0x2c,
+    0xba, 0x57, 0x9d, 0xe5, 0x72, 0xd9, 0x71, 0xde, 0x75, 0x72, 0x8d, 0x03, 0x54, 0xaa, 0xa8, 0x43,
+    0xe7, 0x5d, 0x5b, 0x62, 0x63, 0xa2, 0xd5, 0x3b, 0xe4, 0xc3, 0x5d, 0x60, 0x0f, 0x95, 0xe2, 0x3f,
+    0x81, 0x57, 0x74, 0x2a, 0xb1, 0x2a, 0x73, 0xea, 0x60, 0xec, 0xd2, 0xd8, 0xfc, 0x3f, 0x60, 0xb9,
+    0x73, 0x47, 0xdf, 0xbb, 0x73, 0xa2, 0x97, 0x93, 0x14, 0xf6, 0xa5, 0x74, 0xee, 0x6b, 0x5c, 0xc8,
+    0xf6, 0x26, 0x87, 0xfe, 0x85, 0x33, 0x35, 0xd3, 0xef, 0x2a, 0xc9, 0xea, 0xbc, 0x26, 0xe8, 0xf6,
+    0x8a, 0xe5, 0xa6, 0xbb, 0xa4, 0x6e, 0xba, 0x1f, 0x96, 0x39, 0x13, 0xd4, 0x8d, 0xaf, 0xef, 0x3f,
+    0xdc, 0xb0, 0x04, 0x62, 0x47, 0xc1, 0x71, 0x13, 0x2f, 0xa5, 0x1c, 0x86, 0xc1, 0x3a, 0x16, 0x7a,
+    0xb4, 0x49, 0xc2, 0x9c, 0x8f, 0x3b, 0x0f, 0x1e, 0x34, 0x45, 0x76, 0x2d, 0xdd, 0x39, 0x5e, 0x65,
+    0x7c, 0xcf, 0x3f, 0x34, 0xb7, 0x41, 0x4f, 0x9d, 0xb8, 0xeb, 0x45, 0xbb, 0xb0, 0x2b, 0xc9, 0x72,
+    0x33, 0x8f, 0x43, 0x3a, 0xfc, 0xf6, 0xf6, 0xf4, 0x48, 0x2d, 0x70, 0xa0, 0x73, 0x03, 0x42, 0x95,
+    0x14, 0x6b, 0xd4, 0xc8, 0x15, 0xde, 0x9d, 0x64, 0x7e, 0x4e, 0x68, 0xd7, 0xdb, 0x67, 0xf3, 0x34,
+    0x57, 0xe8, 0xfd, 0x53, 0x71, 0x4c, 0xf2, 0x6f, 0xa3, 0x2a, 0x57, 0x75, 0x26, 0x0e, 0x53, 0xdd,
+    0xa0, 0xbc, 0xe0, 0x16, 0xb7, 0x10, 0xbc, 0xc0, 0xf8, 0xab, 0x2d, 0xde, 0x60, 0xfd, 0x9f, 0x14,
+    0x7f, 0x03, 0xe3, 0xfe, 0x84, 0xfe, 0xbc, 0x10, 0x00, 0x00,
+};
+
+static const PortalAsset PORTAL_ASSETS[] = {
+    { "/", "text/html", ASSET_INDEX_HTML, sizeof(ASSET_INDEX_HTML) },
+};
+static const size_t PORTAL_ASSET_COUNT = sizeof(PORTAL_ASSETS) / sizeof(PORTAL_ASSETS[0]);
+
+}
@@ -1,100 +1,550 @@
 #include "APIServer.h"
+#include "ChunkedWriter.h"
 #include "Device.h"
+#include "Log.h"
+#include "Telemetry.h"
+
+extern "C" {
+#include <user_interface.h>
+}
 
 namespace lovi {
 
-APIServer::APIServer(Device* device, uint16_t port)
+APIServer::APIServer(Device* device, const DeviceIdentity& identity, uint16_t port)
     : _device(device)
+    , _identity(identity)
     , _port(port)
-    , _server(nullptr) {
+    , _server(port)
+    , _routesRegistered(false)
+    , _running(false)
+    , _streamSequence(0)
+    , _streamResync(false)
+    , _lastStreamWrite(0)
+    , _bootTag(0)
+    , _deviceInfoLength(0)
+    , _deviceInfoHash(0)
+    , _otaOwner(0) {
+    _deviceInfoJson[0] = '\0';
+    _deviceInfoETag[0] = '\0';
+    _apiKey[0] = '\0';
 }
 
 APIServer::~APIServer() {
     stop();
 }
 
+#if LOVI_TLS
+bool APIServer::setCertificate(const char* certPem, const char* keyPem) {
+    return _server.setCertificate(certPem, keyPem);
+}
+#endif
+
+void APIServer::setApiKey(const char* apiKey) {
+    strncpy(_apiKey, apiKey ? apiKey : "", sizeof(_apiKey) - 1);
+    _apiKey[sizeof(_apiKey) - 1] = '\0';
+}
+
 void APIServer::begin() {
-    if (_server) {
+    begin(_port);
+}
+
+void APIServer::begin(uint16_t port) {
+    if (_running) {
         return;
     }
-    
-    _server = new ESP8266WebServer(_port);
-    
-    _server->on("/api/device", [this]() { _handleDeviceInfo(); });
-    _server->on("/api/data", [this]() { _handleData(); });
-    _server->onNotFound([this]() { _handleNotFound(); });
-    
-    _server->begin();
-    Serial.print("API Server started on port ");
-    Serial.println(_port);
+
+    // Routes are registered once; the server is only re-bound on restart.
+    if (!_routesRegistered) {
+        static const char* headerKeys[] = { "If-None-Match", "Accept", "X-API-Key" };
+        _server.collectHeaders(headerKeys, 3);
+
+        _server.on("/api/device", [this](HttpRequest& request) { _handleDeviceInfo(request); });
+        // /api/device stays open so discovery can identify the device without a key.
+        _onProtected("/api/data", &APIServer::_handleData);
+        _onProtected("/api/stream", &APIServer::_handleStream);
+        _onProtected("/api/metrics", &APIServer::_handleMetrics);
+        _onProtected("/api/history", &APIServer::_handleHistory);
+        _onProtected("/api/state", &APIServer::_handleState);
+        // The upload route only matches POST, so it must precede the status route.
+        _server.onUpload("/api/ota", [this](HttpRequest& request) { _handleOtaDone(request); },
+                         [this](HttpRequest& request, const HttpUploadChunk& chunk) {
+                             _handleOtaUpload(request, chunk);
+                         });
+        _onProtected("/api/ota", &APIServer::_handleOtaStatus);
+        _server.onNotFound([this](HttpRequest& request) { _handleNotFound(request); });
+        _routesRegistered = true;
+
+        // The sequence number restarts at boot, so data ETags carry a per-run tag.
+        _bootTag = ESP.random();
+    }
+
+    _renderDeviceInfo();
+
+    _port = port;
+    _server.begin(_port);
+    _running = true;
+    Log.print("API Server started on port ");
+    Log.println(_port);
 }
 
 void APIServer::update() {
-    if (_server) {
-        _server->handleClient();
+    if (_running) {
+#if LOVI_TLS
+        // The handshake runs inside the accept, so boost before it starts.
+        _device->getCpuGovernor().setDemand(CpuGovernor::DEMAND_TLS, _server.hasPendingClient());
+#endif
+        _server.update();
+        _serviceStreams();
     }
 }
 
 void APIServer::stop() {
-    if (_server) {
-        _server->stop();
-        delete _server;
-        _server = nullptr;
+    if (_running) {
+        _server.stop();
+        _running = false;
     }
 }
 
-void APIServer::_handleDeviceInfo() {
+void APIServer::_handleDeviceInfo(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    if (_device->getCapabilitiesHash() != _deviceInfoHash) {
+        _renderDeviceInfo();
+    }
+    if (_notModified(request, _deviceInfoETag)) {
+        return;
+    }
+
+    request.send(200, "application/json", _deviceInfoJson, _deviceInfoLength);
+}
+
+void APIServer::_renderDeviceInfo() {
     StaticJsonDocument<256> doc;
     
-    doc["id"] = _getMACAddress();
+    doc["id"] = _identity.id;
     doc["name"] = _device->getName();
-    doc["type"] = _device->getTypeString();
+    doc["type"] = _identity.type;
     doc["firmware_version"] = _device->getFirmwareVersion();
     
     JsonObject capabilities = doc.createNestedObject("capabilities");
     const DeviceInfo::Capabilities& caps = _device->getCapabilities();
-    capabilities["has_presence"] = caps.hasPresence;
-    capabilities["has_motion"] = caps.hasMotion;
-    capabilities["has_temperature"] = caps.hasTemperature;
-    capabilities["has_humidity"] = caps.hasHumidity;
-    capabilities["has_sensitivity"] = caps.hasSensitivity;
+    capabilities["has_presence"] = caps.has(SENSOR_PRESENCE);
+    capabilities["has_motion"] = caps.has(SENSOR_MOTION);
+    capabilities["has_temperature"] = caps.has(SENSOR_TEMPERATURE);
+    capabilities["has_humidity"] = caps.has(SENSOR_HUMIDITY);
+    capabilities["has_sensitivity"] = caps.has(SENSOR_SENSITIVITY);
     capabilities["max_distance"] = caps.maxDistance;
     
-    String response;
-    serializeJson(doc, response);
-    
-    _server->send(200, "application/json", response);
+    _deviceInfoLength = serializeJson(doc, _deviceInfoJson, sizeof(_deviceInfoJson));
+    _deviceInfoHash = _device->getCapabilitiesHash();
+    snprintf(_deviceInfoETag, sizeof(_deviceInfoETag), "\"%08x\"",
+             static_cast<unsigned>(_deviceInfoHash));
 }
 
-void APIServer::_handleData() {
+void APIServer::_handleData(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    bool binary = request.header("Accept").indexOf(TELEMETRY_CONTENT_TYPE) >= 0;
+    uint32_t sequence = _device->getSensorSequence();
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%08x-%u%s\"", static_cast<unsigned>(_bootTag),
+             static_cast<unsigned>(sequence), binary ? "b" : "");
+    request.sendHeader("Vary", "Accept");
+    if (_notModified(request, etag)) {
+        return;
+    }
+
+    if (binary) {
+        uint8_t frame[TELEMETRY_FRAME_SIZE];
+        size_t length = encodeTelemetry(_device->getSensorData(), sequence,
+                                        _device->getChangedFields(), frame, sizeof(frame));
+        request.send(200, TELEMETRY_CONTENT_TYPE, reinterpret_cast<const char*>(frame), length);
+        return;
+    }
+
     StaticJsonDocument<256> doc;
-    
-    const SensorData& data = _device->getSensorData();
-    doc["presence"] = data.presence;
-    doc["motion"] = data.motion;
-    doc["distance"] = data.distance;
-    doc["sensitivity"] = data.sensitivity;
-    doc["temperature"] = data.temperature;
-    doc["humidity"] = data.humidity;
-    doc["uptime"] = data.uptime;
-    
-    String response;
-    serializeJson(doc, response);
-    
-    _server->send(200, "application/json", response);
+    _fillSensorData(doc.to<JsonObject>());
+
+    char json[256];
+    size_t length = serializeJson(doc, json, sizeof(json));
+    request.send(200, "application/json", json, length);
+}
+
+void APIServer::_handleStream(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    if (!request.openEventStream()) {
+        request.send(503, "application/json", "{\"error\":\"Too many streams\"}");
+        return;
+    }
+
+    // Start every subscriber from a full snapshot.
+    _streamResync = true;
+    Log.print("Stream client connected, ");
+    Log.print(getStreamClientCount());
+    Log.println(" active");
+}
+
+bool APIServer::_notModified(HttpRequest& request, const char* etag) {
+    request.sendHeader("ETag", etag);
+    if (!request.hasHeader("If-None-Match")) {
+        return false;
+    }
+
+    const String ifNoneMatch = request.header("If-None-Match");
+    if (ifNoneMatch.indexOf(etag) < 0 && ifNoneMatch != "*") {
+        return false;
+    }
+
+    _device->getMetrics().countNotModified();
+    request.send(304);
+    return true;
+}
+
+void APIServer::_fillSensorData(JsonObject data) {
+    const SensorData& sensors = _device->getSensorData();
+    const DeviceInfo::Capabilities& caps = _device->getCapabilities();
+    if (caps.has(SENSOR_PRESENCE)) {
+        data["presence"] = sensors.presence;
+    }
+    if (caps.has(SENSOR_MOTION)) {
+        data["motion"] = sensors.motion;
+    }
+    if (caps.has(SENSOR_DISTANCE)) {
+        data["distance"] = sensors.distance;
+    }
+    if (caps.has(SENSOR_SENSITIVITY)) {
+        data["sensitivity"] = sensors.sensitivity;
+    }
+    if (caps.has(SENSOR_TEMPERATURE)) {
+        data["temperature"] = sensors.temperature;
+    }
+    if (caps.has(SENSOR_HUMIDITY)) {
+        data["humidity"] = sensors.humidity;
+    }
+    data["uptime"] = sensors.uptime;
+    data["seq"] = _device->getSensorSequence();
+}
+
+void APIServer::_fillSettings(JsonObject settings) {
+    const DeviceSettings& current = _device->getSettings();
+    settings["sensitivity"] = current.sensitivity;
+    settings["led"] = current.ledEnabled;
+    settings["led_brightness"] = current.ledBrightness;
+    settings["broadcast"] = current.broadcast;
+}
+
+void APIServer::_serviceStreams() {
+    uint32_t sequence = _device->getSensorSequence();
+
+    if (_streamResync || sequence != _streamSequence) {
+        _streamResync = false;
+        _streamSequence = sequence;
+
+        StaticJsonDocument<256> doc;
+        _fillSensorData(doc.to<JsonObject>());
+
+        char json[256];
+        serializeJson(doc, json, sizeof(json));
+        _server.sendEvent("data", json, sequence);
+        _lastStreamWrite = millis();
+    } else if (millis() - _lastStreamWrite >= STREAM_KEEPALIVE_MS) {
+        _server.sendComment("keepalive");
+        _lastStreamWrite = millis();
+    }
+}
+
+void APIServer::_handleMetrics(HttpRequest& request) {
+    Metrics& metrics = _device->getMetrics();
+    metrics.countRequest();
+
+    // Written field by field so the per-task section can grow with the
+    // scheduler without a document sized for the worst case.
+    uint32_t freeHeap;
+    uint16_t maxBlock;
+    uint8_t fragmentation;
+    ESP.getHeapStats(&freeHeap, &maxBlock, &fragmentation);
+
+    ChunkedWriter out(request, 200, "application/json");
+    out.format("{\"uptime\":%u,\"heap\":{\"free\":%u,\"max_block\":%u,\"fragmentation\":%u},"
+               "\"wifi\":{\"rssi\":%d},",
+               static_cast<unsigned>(millis() / 1000), static_cast<unsigned>(freeHeap),
+               static_cast<unsigned>(maxBlock), static_cast<unsigned>(fragmentation),
+               static_cast<int>(WiFi.RSSI()));
+    out.format("\"http\":{\"requests\":%u,\"not_modified\":%u,\"not_found\":%u,\"stream_clients\":%u},",
+               static_cast<unsigned>(metrics.getRequestCount()),
+               static_cast<unsigned>(metrics.getNotModifiedCount()),
+               static_cast<unsigned>(metrics.getNotFoundCount()),
+               static_cast<unsigned>(getStreamClientCount()));
+
+    uint16_t dutyCycle = metrics.getDutyCyclePermille();
+    out.format("\"power\":{\"mode\":\"%s\",\"duty_cycle\":%u.%u,\"busy_ms\":%u,\"idle_ms\":%u},",
+               metrics.getPowerMode(), dutyCycle / 10, dutyCycle % 10,
+               static_cast<unsigned>(metrics.getBusyMs()), static_cast<unsigned>(metrics.getIdleMs()));
+
+    uint8_t lastDemand = metrics.getCpuLastDemand();
+    out.format("\"cpu\":{\"mhz\":%u,\"boosts\":%u,\"boosted_ms\":%u,\"last_switch\":%u,"
+               "\"last_demand\":[",
+               static_cast<unsigned>(system_get_cpu_freq()),
+               static_cast<unsigned>(metrics.getCpuBoostCount()),
+               static_cast<unsigned>(metrics.getCpuBoostedMs() + _device->getCpuGovernor().getActiveBoostMs()),
+               static_cast<unsigned>(metrics.getCpuLastSwitchMs() / 1000));
+    const char* separator = "";
+    if (lastDemand & CpuGovernor::DEMAND_TLS) {
+        out.format("%s\"tls\"", separator);
+        separator = ",";
+    }
+    if (lastDemand & CpuGovernor::DEMAND_RADAR) {
+        out.format("%s\"radar\"", separator);
+        separator = ",";
+    }
+    if (lastDemand & CpuGovernor::DEMAND_OTA) {
+        out.format("%s\"ota\"", separator);
+    }
+
+    out.print("]},\"histogram_limits_us\":[");
+    for (uint8_t b = 0; b < LatencyStats::BUCKETS - 1; b++) {
+        out.format("%s%u", b ? "," : "", static_cast<unsigned>(LatencyStats::bucketLimitUs(b)));
+    }
+
+    out.print("],\"tasks\":{");
+    for (uint8_t i = 0; i < metrics.getProbeCount(); i++) {
+        const LatencyStats* stats = metrics.getProbeStats(i);
+        out.format("%s\"%s\":{\"count\":%u,\"min_us\":%u,\"max_us\":%u,\"mean_us\":%u,\"histogram\":[",
+                   i ? "," : "", metrics.getProbeName(i),
+                   static_cast<unsigned>(stats->count), static_cast<unsigned>(stats->minUs),
+                   static_cast<unsigned>(stats->maxUs), static_cast<unsigned>(stats->meanUs()));
+        for (uint8_t b = 0; b < LatencyStats::BUCKETS; b++) {
+            out.format("%s%u", b ? "," : "", static_cast<unsigned>(stats->histogram[b]));
+        }
+        out.print("]}");
+    }
+    out.print("}}");
+    out.end();
+}
+
+void APIServer::_handleHistory(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+
+    const History& history = _device->getHistory();
+    uint32_t since = request.hasArg("since") ? strtoul(request.arg("since").c_str(), nullptr, 10) : 0;
+    uint32_t limit = request.hasArg("limit") ? strtoul(request.arg("limit").c_str(), nullptr, 10) : 0;
+    if (limit == 0) {
+        limit = HISTORY_DEFAULT_LIMIT;
+    } else if (limit > HISTORY_MAX_LIMIT) {
+        limit = HISTORY_MAX_LIMIT;
+    }
+
+    // Entries can outgrow any fixed document, so the body is written in chunks.
+    ChunkedWriter out(request, 200, "application/json");
+    out.format("{\"now_ms\":%u,\"oldest\":%u,\"newest\":%u,\"truncated\":%s,\"entries\":[",
+               static_cast<unsigned>(millis()),
+               static_cast<unsigned>(history.getOldestSequence()),
+               static_cast<unsigned>(history.isEmpty() ? 0 : history.getNewestSequence()),
+               !history.isEmpty() && since + 1 < history.getOldestSequence() ? "true" : "false");
+
+    History::Cursor cursor = history.since(since);
+    HistoryEntry entry;
+    uint32_t count = 0;
+    uint32_t last = since;
+    while (count < limit && cursor.next(entry)) {
+        out.format("%s[%u,%u,%u,%u,%u]",
+                   count ? "," : "",
+                   static_cast<unsigned>(entry.sequence),
+                   static_cast<unsigned>(entry.timeMs),
+                   (entry.presence ? 1 : 0) | (entry.presenceEdge ? 2 : 0),
+                   (entry.motion ? 1 : 0) | (entry.motionEdge ? 2 : 0),
+                   static_cast<unsigned>(entry.distance * 100.0f + 0.5f));
+        last = entry.sequence;
+        count++;
+    }
+
+    out.format("],\"next\":%u}", static_cast<unsigned>(last));
+    out.end();
+}
+
+// One round trip for info, data and settings. Clients pass the section
+// versions they already hold (?info=<hash>&settings=<n>) and unchanged
+// sections come back as null. POST applies {"settings": {...}} first and
+// always answers with every section.
+void APIServer::_handleState(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+
+    bool post = request.isPost();
+    if (post && !_applySettings(request)) {
+        request.send(400, "application/json", "{\"error\":\"Invalid settings\"}");
+        return;
+    }
+
+    if (_device->getCapabilitiesHash() != _deviceInfoHash) {
+        _renderDeviceInfo();
+    }
+
+    char infoVersion[9];
+    snprintf(infoVersion, sizeof(infoVersion), "%08x", static_cast<unsigned>(_deviceInfoHash));
+    uint32_t settingsVersion = _device->getSettingsVersion();
+
+    bool sendInfo = post || !request.hasArg("info") || request.arg("info") != infoVersion;
+    bool sendSettings = post || !request.hasArg("settings")
+        || strtoul(request.arg("settings").c_str(), nullptr, 10) != settingsVersion;
+
+    StaticJsonDocument<STATE_DOCUMENT_SIZE> doc;
+    JsonObject versions = doc.createNestedObject("versions");
+    versions["info"] = infoVersion;
+    versions["data"] = _device->getSensorSequence();
+    versions["settings"] = settingsVersion;
+
+    if (sendInfo) {
+        doc["info"] = serialized(_deviceInfoJson, _deviceInfoLength);
+    } else {
+        doc["info"] = nullptr;
+    }
+    _fillSensorData(doc.createNestedObject("data"));
+    if (sendSettings) {
+        _fillSettings(doc.createNestedObject("settings"));
+    } else {
+        doc["settings"] = nullptr;
+    }
+
+    ChunkedWriter out(request, 200, "application/json");
+    serializeJson(doc, out);
+    out.end();
+}
+
+bool APIServer::_applySettings(HttpRequest& request) {
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, request.body())) {
+        return false;
+    }
+
+    JsonObject changes = doc["settings"];
+    if (changes.isNull()) {
+        return false;
+    }
+
+    DeviceSettings settings = _device->getSettings();
+    if (changes.containsKey("sensitivity")) {
+        settings.sensitivity = constrain(changes["sensitivity"].as<int>(), 0, 100);
+    }
+    if (changes.containsKey("led")) {
+        settings.ledEnabled = changes["led"].as<bool>();
+    }
+    if (changes.containsKey("led_brightness")) {
+        settings.ledBrightness = constrain(changes["led_brightness"].as<int>(), 0, 255);
+    }
+    if (changes.containsKey("broadcast")) {
+        settings.broadcast = changes["broadcast"].as<bool>();
+    }
+    _device->applySettings(settings);
+    return true;
+}
+
+void APIServer::_handleOtaStatus(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    _sendOtaStatus(request, 200);
+}
+
+// Chunks from any upload but the one that started the update are ignored,
+// so a second concurrent upload cannot interleave with the first.
+void APIServer::_handleOtaUpload(HttpRequest& request, const HttpUploadChunk& chunk) {
+    OtaUpdater& ota = _device->getOtaUpdater();
+    uintptr_t id = request.connectionId();
+
+    switch (chunk.status) {
+        case HttpUploadChunk::START:
+            if (ota.isActive() || !_authorized(request)) {
+                return;
+            }
+            _otaOwner = id;
+            ota.begin(strtoul(request.arg("size").c_str(), nullptr, 10), request.arg("md5").c_str());
+            break;
+        case HttpUploadChunk::WRITE:
+            if (id == _otaOwner) {
+                ota.write(chunk.data, chunk.length);
+            }
+            break;
+        case HttpUploadChunk::END:
+            if (id == _otaOwner) {
+                ota.end();
+            }
+            break;
+        case HttpUploadChunk::ABORTED:
+            if (id == _otaOwner) {
+                ota.abort("Upload aborted");
+                _otaOwner = 0;
+            }
+            break;
+    }
 }
 
-void APIServer::_handleNotFound() {
-    _server->send(404, "application/json", "{\"error\":\"Not found\"}");
+void APIServer::_handleOtaDone(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    if (!_authorized(request)) {
+        _sendUnauthorized(request);
+        return;
+    }
+    if (!_otaOwner || request.connectionId() != _otaOwner) {
+        if (_device->getOtaUpdater().isActive()) {
+            request.send(409, "application/json", "{\"error\":\"Update already in progress\"}");
+        } else {
+            request.send(400, "application/json", "{\"error\":\"No firmware uploaded\"}");
+        }
+        return;
+    }
+
+    _otaOwner = 0;
+    OtaState state = _device->getOtaUpdater().getState();
+    _sendOtaStatus(request, state == OtaState::SUCCESS ? 200 : 400);
+}
+
+void APIServer::_sendOtaStatus(HttpRequest& request, int code) {
+    const OtaUpdater& ota = _device->getOtaUpdater();
+    StaticJsonDocument<192> doc;
+    doc["state"] = OtaUpdater::getStateString(ota.getState());
+    doc["written"] = ota.getWritten();
+    doc["size"] = ota.getSize();
+    doc["progress"] = ota.getProgress();
+    doc["error"] = ota.getError();
+
+    char json[192];
+    size_t length = serializeJson(doc, json, sizeof(json));
+    request.send(code, "application/json", json, length);
+}
+
+void APIServer::_onProtected(const char* path, RequestHandler handler) {
+    _server.on(path, [this, handler](HttpRequest& request) {
+        if (_apiKey[0] && !_authorized(request)) {
+            _sendUnauthorized(request);
+            return;
+        }
+        (this->*handler)(request);
+    });
+}
+
+void APIServer::_sendUnauthorized(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    request.send(401, "application/json", "{\"error\":\"Unauthorized\"}");
+}
+
+// Compares the whole stored key whatever the input, so response time says
+// nothing about how many leading characters matched.
+bool APIServer::_authorized(HttpRequest& request) {
+    if (!_apiKey[0] || !request.hasHeader("X-API-Key")) {
+        return false;
+    }
+
+    String given = request.header("X-API-Key");
+    size_t length = strlen(_apiKey);
+    uint8_t diff = given.length() != length;
+    for (size_t i = 0; i < length; i++) {
+        char c = i < given.length() ? given[i] : 0;
+        diff |= c ^ _apiKey[i];
+    }
+    return diff == 0;
 }
 
-String APIServer::_getMACAddress() {
-    uint8_t mac[6];
-    WiFi.macAddress(mac);
-    char buffer[18];
-    snprintf(buffer, sizeof(buffer), "%02X%02X%02X%02X%02X%02X",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    return String(buffer);
+void APIServer::_handleNotFound(HttpRequest& request) {
+    _device->getMetrics().countRequest();
+    _device->getMetrics().countNotFound();
+    request.send(404, "application/json", "{\"error\":\"Not found\"}");
 }
 
 }
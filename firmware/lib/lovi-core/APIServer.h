@@ -1,9 +1,9 @@
 #pragma once
 
 #include <Arduino.h>
-#include <ESP8266WebServer.h>
 #include <ArduinoJson.h>
 #include "types.h"
+#include "HttpServer.h"
 
 namespace lovi {
 
@@ -11,25 +11,73 @@ class Device;
 
 class APIServer {
 public:
-    APIServer(Device* device, uint16_t port = 80);
+    APIServer(Device* device, const DeviceIdentity& identity, uint16_t port = 80);
     ~APIServer();
 
+    static const uint32_t STREAM_KEEPALIVE_MS = 15000;
+    static const size_t DEVICE_INFO_BUFFER_SIZE = 256;
+    static const uint16_t HISTORY_DEFAULT_LIMIT = 128;
+    static const uint16_t HISTORY_MAX_LIMIT = 512;
+    static const size_t STATE_DOCUMENT_SIZE = 768;
+    static const size_t API_KEY_SIZE = 48;
+
     void begin();
+    void begin(uint16_t port);
     void update();
     void stop();
 
-    bool isRunning() const { return _server != nullptr; }
+    // When set, every endpoint except /api/device requires an X-API-Key
+    // header; OTA uploads are refused until a key is configured.
+    void setApiKey(const char* apiKey);
+#if LOVI_TLS
+    bool setCertificate(const char* certPem, const char* keyPem);
+#endif
+
+    bool isRunning() const { return _running; }
+    uint8_t getStreamClientCount() { return _server.getEventStreamCount(); }
 
 private:
+    typedef void (APIServer::*RequestHandler)(HttpRequest&);
+
     Device* _device;
+    const DeviceIdentity& _identity;
     uint16_t _port;
-    ESP8266WebServer* _server;
+    HttpServer _server;
+    bool _routesRegistered;
+    bool _running;
+    uint32_t _streamSequence;
+    bool _streamResync;
+    uint32_t _lastStreamWrite;
+    uint32_t _bootTag;
+
+    char _deviceInfoJson[DEVICE_INFO_BUFFER_SIZE];
+    size_t _deviceInfoLength;
+    uint32_t _deviceInfoHash;
+    char _deviceInfoETag[12];
+    char _apiKey[API_KEY_SIZE];
+    uintptr_t _otaOwner;
+
+    void _handleDeviceInfo(HttpRequest& request);
+    void _handleData(HttpRequest& request);
+    void _handleStream(HttpRequest& request);
+    void _handleMetrics(HttpRequest& request);
+    void _handleHistory(HttpRequest& request);
+    void _handleState(HttpRequest& request);
+    void _handleOtaStatus(HttpRequest& request);
+    void _handleOtaUpload(HttpRequest& request, const HttpUploadChunk& chunk);
+    void _handleOtaDone(HttpRequest& request);
+    void _handleNotFound(HttpRequest& request);
 
-    void _handleDeviceInfo();
-    void _handleData();
-    void _handleNotFound();
-    
-    String _getMACAddress();
+    void _renderDeviceInfo();
+    bool _notModified(HttpRequest& request, const char* etag);
+    void _onProtected(const char* path, RequestHandler handler);
+    bool _authorized(HttpRequest& request);
+    void _sendUnauthorized(HttpRequest& request);
+    void _sendOtaStatus(HttpRequest& request, int code);
+    void _fillSensorData(JsonObject data);
+    void _fillSettings(JsonObject settings);
+    bool _applySettings(HttpRequest& request);
+    void _serviceStreams();
 };
 
 }
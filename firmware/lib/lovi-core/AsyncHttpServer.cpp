@@ -0,0 +1,308 @@
+#include "HttpServer.h"
+#include "Log.h"
+
+#if LOVI_ASYNC_HTTP
+
+#include <ESPAsyncTCP.h>
+#include <ESPAsyncWebServer.h>
+#include <lwip/opt.h>
+#include <new>
+
+namespace lovi {
+
+struct AsyncHttpServerImpl {
+    explicit AsyncHttpServerImpl(uint16_t port) : web(port), events("") {}
+
+    AsyncWebServer web;
+    AsyncEventSource events;
+};
+
+alignas(AsyncHttpServerImpl) static uint8_t _implStorage[sizeof(AsyncHttpServerImpl)];
+static bool _implInUse = false;
+
+// The multipart parser can hold up to one segment beyond a full window.
+static const size_t UPLOAD_BUFFER_SIZE = TCP_WND + TCP_MSS;
+
+AsyncHttpRequest::AsyncHttpRequest(AsyncHttpServer& server, AsyncWebServerRequest* request)
+    : _server(server)
+    , _request(request)
+    , _stream(nullptr)
+    , _headerCount(0) {
+}
+
+bool AsyncHttpRequest::isPost() {
+    return _request->method() == HTTP_POST;
+}
+
+String AsyncHttpRequest::body() {
+    return _request->_tempObject ? String(static_cast<const char*>(_request->_tempObject)) : String();
+}
+
+bool AsyncHttpRequest::hasHeader(const char* name) {
+    return _request->hasHeader(name);
+}
+
+String AsyncHttpRequest::header(const char* name) {
+    AsyncWebHeader* header = _request->getHeader(name);
+    return header ? header->value() : String();
+}
+
+bool AsyncHttpRequest::hasArg(const char* name) {
+    return _request->hasArg(name);
+}
+
+String AsyncHttpRequest::arg(const char* name) {
+    return _request->arg(name);
+}
+
+void AsyncHttpRequest::sendHeader(const char* name, const char* value) {
+    if (_headerCount >= MAX_HEADERS) {
+        return;
+    }
+    Header& header = _headers[_headerCount++];
+    header.name = name;
+    strncpy(header.value, value, sizeof(header.value) - 1);
+    header.value[sizeof(header.value) - 1] = '\0';
+}
+
+void AsyncHttpRequest::send(int code) {
+    _send(_request->beginResponse(code));
+}
+
+void AsyncHttpRequest::send(int code, const char* contentType, const char* body) {
+    send(code, contentType, body, strlen(body));
+}
+
+void AsyncHttpRequest::send(int code, const char* contentType, const char* body, size_t length) {
+    AsyncResponseStream* response = _request->beginResponseStream(contentType, length);
+    response->setCode(code);
+    response->write(reinterpret_cast<const uint8_t*>(body), length);
+    _send(response);
+}
+
+void AsyncHttpRequest::send_P(int code, PGM_P contentType, PGM_P body, size_t length) {
+    _send(_request->beginResponse_P(code, String(FPSTR(contentType)),
+                                    reinterpret_cast<const uint8_t*>(body), length));
+}
+
+void AsyncHttpRequest::beginChunked(int code, const char* contentType) {
+    _stream = _request->beginResponseStream(contentType);
+    _stream->setCode(code);
+}
+
+void AsyncHttpRequest::sendChunk(const char* data, size_t length) {
+    if (_stream) {
+        _stream->write(reinterpret_cast<const uint8_t*>(data), length);
+    }
+}
+
+void AsyncHttpRequest::endChunked() {
+    if (_stream) {
+        _send(_stream);
+        _stream = nullptr;
+    }
+}
+
+bool AsyncHttpRequest::openEventStream() {
+    if (_server._impl->events.count() >= AsyncHttpServer::MAX_EVENT_STREAMS) {
+        return false;
+    }
+    // Same hand-over AsyncEventSource::handleRequest() performs; the source
+    // takes ownership of the client once the response is sent.
+    _request->send(new AsyncEventSourceResponse(&_server._impl->events));
+    return true;
+}
+
+void AsyncHttpRequest::_send(AsyncWebServerResponse* response) {
+    for (uint8_t i = 0; i < _headerCount; i++) {
+        response->addHeader(_headers[i].name, _headers[i].value);
+    }
+    _request->send(response);
+}
+
+AsyncHttpServer::AsyncHttpServer(uint16_t port)
+    : _impl(nullptr)
+    , _port(port)
+    , _pending() {
+    if (_implInUse) {
+        // Every handler would dereference a null backend on the first request.
+        Log.println("Only one AsyncHttpServer may exist");
+        panic();
+    }
+    _impl = new (_implStorage) AsyncHttpServerImpl(port);
+    _implInUse = true;
+}
+
+AsyncHttpServer::~AsyncHttpServer() {
+    free(_pending.data);
+    _impl->~AsyncHttpServerImpl();
+    _implInUse = false;
+}
+
+void AsyncHttpServer::collectHeaders(const char**, size_t) {
+    // ESPAsyncWebServer keeps every request header.
+}
+
+void AsyncHttpServer::on(const char* path, Handler handler) {
+    _impl->web.on(path, HTTP_ANY, [this, handler](AsyncWebServerRequest* raw) {
+        AsyncHttpRequest request(*this, raw);
+        handler(request);
+    }, nullptr, _collectBody);
+}
+
+void AsyncHttpServer::onUpload(const char* path, Handler handler, UploadHandler upload) {
+    _impl->web.on(path, HTTP_POST, [this, handler](AsyncWebServerRequest* raw) {
+        // The body has arrived, but its last chunks may still be buffered.
+        if (raw == _pending.request) {
+            _pending.handler = handler;
+            _pending.complete = true;
+            return;
+        }
+        AsyncHttpRequest request(*this, raw);
+        handler(request);
+    }, [this, upload](AsyncWebServerRequest* raw, const String&, size_t index,
+                      uint8_t* data, size_t length, bool final) {
+        _queueUpload(raw, upload, index, data, length, final);
+    }, nullptr);
+}
+
+void AsyncHttpServer::_queueUpload(AsyncWebServerRequest* request, const UploadHandler& upload,
+                                   size_t index, const uint8_t* data, size_t length, bool final) {
+    if (index == 0 && !_pending.request) {
+        uint8_t* buffer = static_cast<uint8_t*>(malloc(UPLOAD_BUFFER_SIZE));
+        if (!buffer) {
+            return;
+        }
+        _pending = PendingUpload();
+        _pending.request = request;
+        _pending.upload = upload;
+        _pending.data = buffer;
+        // The request is freed right after this, so only the pointer is compared.
+        request->onDisconnect([this, request]() {
+            if (request == _pending.request) {
+                _pending.disconnected = true;
+            }
+        });
+    }
+    if (request != _pending.request || _pending.aborted || _pending.disconnected) {
+        return;
+    }
+
+    if (_pending.length + length > UPLOAD_BUFFER_SIZE) {
+        _pending.aborted = true;
+        return;
+    }
+    memcpy(_pending.data + _pending.length, data, length);
+    _pending.length += length;
+    _pending.final = final;
+    request->client()->ackLater();
+}
+
+void AsyncHttpServer::_serviceUpload() {
+    if (!_pending.request) {
+        return;
+    }
+
+    AsyncHttpRequest request(*this, _pending.request);
+    bool failed = _pending.aborted || _pending.disconnected;
+    // Data that arrives while the handler yields is appended behind this.
+    size_t length = _pending.length;
+    if (!failed) {
+        if (!_pending.started) {
+            HttpUploadChunk start = { HttpUploadChunk::START, nullptr, 0, 0 };
+            _pending.upload(request, start);
+            _pending.started = true;
+        }
+        if (length) {
+            HttpUploadChunk chunk = { HttpUploadChunk::WRITE, _pending.data, length, _pending.offset };
+            _pending.upload(request, chunk);
+            _pending.offset += length;
+        }
+    }
+    if (length) {
+        _pending.length -= length;
+        memmove(_pending.data, _pending.data + length, _pending.length);
+        if (!_pending.disconnected) {
+            // Reopens the window; ack() is capped at what ackLater() held back.
+            _pending.request->client()->ack(SIZE_MAX);
+        }
+    }
+
+    // The handler may have yielded to a disconnect.
+    failed = _pending.aborted || _pending.disconnected;
+    if (!failed && (_pending.length || !_pending.complete)) {
+        return;
+    }
+
+    if (_pending.started) {
+        HttpUploadChunk end = { HttpUploadChunk::END, nullptr, 0, _pending.offset };
+        if (failed || !_pending.final) {
+            end.status = HttpUploadChunk::ABORTED;
+        }
+        _pending.upload(request, end);
+    }
+    if (_pending.complete && !_pending.disconnected) {
+        _pending.handler(request);
+    }
+    free(_pending.data);
+    _pending = PendingUpload();
+}
+
+void AsyncHttpServer::_collectBody(AsyncWebServerRequest* request, uint8_t* data,
+                                   size_t length, size_t index, size_t total) {
+    // Bodies arrive in pieces; the request frees _tempObject when it ends.
+    if (index == 0) {
+        if (total > MAX_BODY_SIZE || request->_tempObject) {
+            return;
+        }
+        request->_tempObject = malloc(total + 1);
+        if (!request->_tempObject) {
+            return;
+        }
+        static_cast<char*>(request->_tempObject)[total] = '\0';
+    }
+    if (request->_tempObject && index + length <= total) {
+        memcpy(static_cast<char*>(request->_tempObject) + index, data, length);
+    }
+}
+
+void AsyncHttpServer::onNotFound(Handler handler) {
+    _impl->web.onNotFound([this, handler](AsyncWebServerRequest* raw) {
+        AsyncHttpRequest request(*this, raw);
+        handler(request);
+    });
+}
+
+void AsyncHttpServer::begin(uint16_t port) {
+    if (port != _port) {
+        Log.println("Async HTTP backend cannot change port; keeping the original");
+    }
+    _impl->web.begin();
+}
+
+void AsyncHttpServer::update() {
+    _serviceUpload();
+}
+
+void AsyncHttpServer::stop() {
+    _impl->events.close();
+    _impl->web.end();
+}
+
+uint8_t AsyncHttpServer::getEventStreamCount() {
+    return _impl->events.count();
+}
+
+void AsyncHttpServer::sendEvent(const char* event, const char* data, uint32_t id) {
+    _impl->events.send(data, event, id);
+}
+
+void AsyncHttpServer::sendComment(const char* comment) {
+    // AsyncEventSource has no comment frames; send a named event that
+    // clients skip instead.
+    _impl->events.send("", comment, 0);
+}
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "HttpUpload.h"
+
+// ESPAsyncWebServer's method enum clashes with ESP8266WebServer's, and the
+// captive portal still uses the latter, so its types stay out of headers.
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncResponseStream;
+
+namespace lovi {
+
+class AsyncHttpServer;
+struct AsyncHttpServerImpl;
+
+// Responses are built lazily by ESPAsyncWebServer, so everything handed to
+// send()/sendHeader() is copied before the handler returns; only send_P()
+// bodies, which live in flash, are referenced in place.
+class AsyncHttpRequest {
+public:
+    static const uint8_t MAX_HEADERS = 4;
+
+    AsyncHttpRequest(AsyncHttpServer& server, AsyncWebServerRequest* request);
+
+    bool isPost();
+    String body();
+    bool hasHeader(const char* name);
+    String header(const char* name);
+    bool hasArg(const char* name);
+    String arg(const char* name);
+    uintptr_t connectionId() const { return reinterpret_cast<uintptr_t>(_request); }
+
+    void sendHeader(const char* name, const char* value);
+    void send(int code);
+    void send(int code, const char* contentType, const char* body);
+    void send(int code, const char* contentType, const char* body, size_t length);
+    void send_P(int code, PGM_P contentType, PGM_P body, size_t length);
+
+    void beginChunked(int code, const char* contentType);
+    void sendChunk(const char* data, size_t length);
+    void endChunked();
+
+    bool openEventStream();
+
+private:
+    struct Header {
+        const char* name;
+        char value[40];
+    };
+
+    AsyncHttpServer& _server;
+    AsyncWebServerRequest* _request;
+    AsyncResponseStream* _stream;
+    Header _headers[MAX_HEADERS];
+    uint8_t _headerCount;
+
+    void _send(AsyncWebServerResponse* response);
+};
+
+class AsyncHttpServer {
+public:
+    typedef std::function<void(AsyncHttpRequest&)> Handler;
+    typedef std::function<void(AsyncHttpRequest&, const HttpUploadChunk&)> UploadHandler;
+
+    static const uint8_t MAX_EVENT_STREAMS = 4;
+    static const size_t MAX_BODY_SIZE = 1024;
+
+    // The listening port is fixed when the server is constructed, and the
+    // backend lives in static storage, so only one instance may exist; a
+    // second one panics.
+    explicit AsyncHttpServer(uint16_t port);
+    ~AsyncHttpServer();
+
+    void collectHeaders(const char** keys, size_t count);
+    void on(const char* path, Handler handler);
+    void onNotFound(Handler handler);
+    // Upload data is buffered in the TCP callbacks and handed to upload from
+    // update(), so flash writes run in the loop like on the synchronous
+    // backend. handler follows the last chunk. One upload is buffered at a
+    // time; chunks of a concurrent one are dropped.
+    void onUpload(const char* path, Handler handler, UploadHandler upload);
+
+    void begin(uint16_t port);
+    void update();
+    void stop();
+
+    uint8_t getEventStreamCount();
+    void sendEvent(const char* event, const char* data, uint32_t id);
+    void sendComment(const char* comment);
+
+private:
+    friend class AsyncHttpRequest;
+
+    // The sender's TCP window stays closed while data waits here, which
+    // bounds how much can arrive before update() drains it.
+    struct PendingUpload {
+        AsyncWebServerRequest* request;
+        UploadHandler upload;
+        Handler handler;
+        uint8_t* data;
+        size_t length;
+        size_t offset;
+        bool started;
+        bool final;
+        bool complete;
+        bool aborted;
+        bool disconnected;
+    };
+
+    AsyncHttpServerImpl* _impl;
+    uint16_t _port;
+    PendingUpload _pending;
+
+    void _queueUpload(AsyncWebServerRequest* request, const UploadHandler& upload,
+                      size_t index, const uint8_t* data, size_t length, bool final);
+    void _serviceUpload();
+
+    static void _collectBody(AsyncWebServerRequest* request, uint8_t* data,
+                             size_t length, size_t index, size_t total);
+};
+
+}
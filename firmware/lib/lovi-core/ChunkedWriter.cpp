@@ -0,0 +1,79 @@
+#include "ChunkedWriter.h"
+#include <stdarg.h>
+
+namespace lovi {
+
+ChunkedWriter::ChunkedWriter(HttpRequest& request, int code, const char* contentType)
+    : _request(request)
+    , _length(0)
+    , _ended(false) {
+    _request.beginChunked(code, contentType);
+}
+
+ChunkedWriter::~ChunkedWriter() {
+    end();
+}
+
+size_t ChunkedWriter::write(uint8_t byte) {
+    if (_length == BUFFER_SIZE) {
+        _flush();
+    }
+    _buffer[_length++] = static_cast<char>(byte);
+    return 1;
+}
+
+size_t ChunkedWriter::write(const uint8_t* data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        if (_length == BUFFER_SIZE) {
+            _flush();
+        }
+        size_t count = size - written;
+        if (count > BUFFER_SIZE - _length) {
+            count = BUFFER_SIZE - _length;
+        }
+        memcpy(_buffer + _length, data + written, count);
+        _length += count;
+        written += count;
+    }
+    return size;
+}
+
+size_t ChunkedWriter::format(const char* format, ...) {
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        size_t space = BUFFER_SIZE - _length;
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(_buffer + _length, space, format, args);
+        va_end(args);
+        if (length < 0) {
+            return 0;
+        }
+        // vsnprintf needs room for the terminator even though it is not sent.
+        if (static_cast<size_t>(length) < space || _length == 0) {
+            size_t kept = static_cast<size_t>(length) < space ? length : space - 1;
+            _length += kept;
+            return kept;
+        }
+        _flush();
+    }
+    return 0;
+}
+
+void ChunkedWriter::end() {
+    if (_ended) {
+        return;
+    }
+    _flush();
+    _request.endChunked();
+    _ended = true;
+}
+
+void ChunkedWriter::_flush() {
+    if (_length) {
+        _request.sendChunk(_buffer, _length);
+        _length = 0;
+    }
+}
+
+}
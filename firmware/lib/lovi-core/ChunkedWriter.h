@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+#include "HttpServer.h"
+
+namespace lovi {
+
+// Print sink that streams a response body with chunked transfer encoding
+// through a fixed buffer, so serializeJson() and hand-written output reach
+// the connection without first being assembled in a heap String. Each
+// format() call must produce less than BUFFER_SIZE bytes.
+class ChunkedWriter : public Print {
+public:
+    static const size_t BUFFER_SIZE = 256;
+
+    ChunkedWriter(HttpRequest& request, int code, const char* contentType);
+    ~ChunkedWriter();
+
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t* data, size_t size) override;
+    using Print::write;
+
+    // snprintf() straight into the buffer; unlike Print::printf() it never
+    // falls back to a heap allocation for long output.
+    size_t format(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // Sends what is buffered and the final chunk. Called by the destructor
+    // if the handler does not.
+    void end();
+
+private:
+    HttpRequest& _request;
+    char _buffer[BUFFER_SIZE];
+    size_t _length;
+    bool _ended;
+
+    void _flush();
+};
+
+}
@@ -0,0 +1,200 @@
+#include "ConnectionManager.h"
+#include "Device.h"
+#include "Log.h"
+
+namespace lovi {
+
+ConnectionManager::ConnectionManager(Device* device, uint16_t port)
+    : _device(device)
+    , _port(port)
+    , _ssid(nullptr)
+    , _password(nullptr)
+    , _state(ConnectionState::IDLE)
+    , _fastConnect(false)
+    , _stateSince(0)
+    , _backoffMs(BACKOFF_INITIAL_MS)
+    , _attempts(0)
+    , _everConnected(false) {
+}
+
+void ConnectionManager::begin(const char* ssid, const char* password, const NetworkCache* cache) {
+    // PORTAL is left by the portal provisioning new credentials.
+    if (_state != ConnectionState::IDLE && _state != ConnectionState::PORTAL) {
+        return;
+    }
+
+    _ssid = ssid;
+    _password = password;
+    _cache = cache ? *cache : NetworkCache();
+    _attempts = 0;
+    _backoffMs = BACKOFF_INITIAL_MS;
+
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+
+    // The portal hands over an association it already verified.
+    if (WiFi.status() == WL_CONNECTED && WiFi.SSID() == ssid) {
+        _onConnected();
+        return;
+    }
+
+    WiFi.mode(WIFI_STA);
+
+    if (_cache.valid) {
+        _startFastAttempt();
+    } else {
+        _startAttempt();
+    }
+}
+
+void ConnectionManager::update() {
+    uint32_t elapsed = millis() - _stateSince;
+    wl_status_t status = WiFi.status();
+
+    switch (_state) {
+        case ConnectionState::CONNECTING:
+            if (status == WL_CONNECTED) {
+                _onConnected();
+            } else if (_fastConnect
+                       && (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL
+                           || status == WL_WRONG_PASSWORD || elapsed >= FAST_CONNECT_TIMEOUT_MS)) {
+                // The cached AP or lease went stale, or the AP rejected the cached
+                // BSSID: drop it and do a full scan + DHCP.
+                Log.println("Fast reconnect failed, scanning");
+                _cache.valid = false;
+                WiFi.disconnect();
+                WiFi.config(IPAddress(), IPAddress(), IPAddress());
+                _startAttempt();
+            } else if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL
+                       || status == WL_WRONG_PASSWORD || elapsed >= CONNECT_TIMEOUT_MS) {
+                _attemptFailed();
+            }
+            break;
+
+        case ConnectionState::CONNECTED:
+            if (status != WL_CONNECTED) {
+                Log.println("WiFi connection lost");
+                _stopServices();
+                _backoffMs = BACKOFF_INITIAL_MS;
+                _setState(ConnectionState::BACKOFF);
+            }
+            break;
+
+        case ConnectionState::BACKOFF:
+            if (elapsed >= _backoffMs) {
+                if (_cache.valid) {
+                    _startFastAttempt();
+                } else {
+                    _startAttempt();
+                }
+            }
+            break;
+
+        case ConnectionState::IDLE:
+        case ConnectionState::PORTAL:
+            break;
+    }
+}
+
+void ConnectionManager::stop() {
+    _stopServices();
+    WiFi.disconnect();
+    _setState(ConnectionState::IDLE);
+}
+
+const char* ConnectionManager::getStateString() const {
+    switch (_state) {
+        case ConnectionState::IDLE:
+            return "idle";
+        case ConnectionState::CONNECTING:
+            return "connecting";
+        case ConnectionState::CONNECTED:
+            return "connected";
+        case ConnectionState::BACKOFF:
+            return "backoff";
+        case ConnectionState::PORTAL:
+            return "portal";
+        default:
+            return "unknown";
+    }
+}
+
+void ConnectionManager::_startAttempt() {
+    Log.print("Connecting to WiFi: ");
+    Log.println(_ssid);
+    _fastConnect = false;
+    WiFi.begin(_ssid, _password);
+    _attempts++;
+    _setState(ConnectionState::CONNECTING);
+}
+
+void ConnectionManager::_startFastAttempt() {
+    Log.print("Reconnecting to WiFi on channel ");
+    Log.println(_cache.channel);
+    _fastConnect = true;
+    WiFi.config(IPAddress(_cache.ip), IPAddress(_cache.gateway),
+                IPAddress(_cache.subnet), IPAddress(_cache.dns));
+    WiFi.begin(_ssid, _password, _cache.channel, _cache.bssid);
+    _setState(ConnectionState::CONNECTING);
+}
+
+void ConnectionManager::_onConnected() {
+    Log.print("Connected! IP: ");
+    Log.println(WiFi.localIP());
+    _captureNetworkCache();
+    _attempts = 0;
+    _everConnected = true;
+    _setState(ConnectionState::CONNECTED);
+    _startServices();
+}
+
+void ConnectionManager::_captureNetworkCache() {
+    memcpy(_cache.bssid, WiFi.BSSID(), sizeof(_cache.bssid));
+    _cache.channel = WiFi.channel();
+    _cache.ip = WiFi.localIP();
+    _cache.gateway = WiFi.gatewayIP();
+    _cache.subnet = WiFi.subnetMask();
+    _cache.dns = WiFi.dnsIP();
+    _cache.valid = true;
+}
+
+void ConnectionManager::_attemptFailed() {
+    Log.println("WiFi connection failed!");
+    WiFi.disconnect();
+
+    // Credentials that never worked since boot are likely wrong; once we
+    // have been online, keep retrying so a router reboot heals itself.
+    if (!_everConnected && _attempts >= MAX_ATTEMPTS_BEFORE_PORTAL) {
+        _setState(ConnectionState::PORTAL);
+        return;
+    }
+
+    uint8_t shift = _attempts == 0 ? 0 : (_attempts > 6 ? 5 : _attempts - 1);
+    _backoffMs = BACKOFF_INITIAL_MS << shift;
+    if (_backoffMs > BACKOFF_MAX_MS) {
+        _backoffMs = BACKOFF_MAX_MS;
+    }
+    _setState(ConnectionState::BACKOFF);
+}
+
+void ConnectionManager::_setState(ConnectionState state) {
+    _state = state;
+    _stateSince = millis();
+    if (_callback) {
+        _callback(state);
+    }
+}
+
+void ConnectionManager::_startServices() {
+    _device->startMDNS(_port);
+    _device->startAPIServer(_port);
+    _device->startBroadcast();
+}
+
+void ConnectionManager::_stopServices() {
+    _device->stopBroadcast();
+    _device->stopAPIServer();
+    _device->stopMDNS();
+}
+
+}
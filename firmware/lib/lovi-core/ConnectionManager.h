@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <functional>
+#include "types.h"
+
+namespace lovi {
+
+class Device;
+
+enum class ConnectionState : uint8_t {
+    IDLE = 0,
+    CONNECTING = 1,
+    CONNECTED = 2,
+    BACKOFF = 3,
+    PORTAL = 4
+};
+
+class ConnectionManager {
+public:
+    typedef std::function<void(ConnectionState)> StateCallback;
+
+    static const uint32_t CONNECT_TIMEOUT_MS = 30000;
+    static const uint32_t FAST_CONNECT_TIMEOUT_MS = 5000;
+    static const uint32_t BACKOFF_INITIAL_MS = 2000;
+    static const uint32_t BACKOFF_MAX_MS = 60000;
+    static const uint8_t MAX_ATTEMPTS_BEFORE_PORTAL = 3;
+
+    ConnectionManager(Device* device, uint16_t port = 80);
+
+    void begin(const char* ssid, const char* password, const NetworkCache* cache = nullptr);
+    void update();
+    void stop();
+
+    void onStateChange(StateCallback callback) { _callback = callback; }
+
+    ConnectionState getState() const { return _state; }
+    const char* getStateString() const;
+    bool isConnected() const { return _state == ConnectionState::CONNECTED; }
+    const NetworkCache& getNetworkCache() const { return _cache; }
+
+private:
+    Device* _device;
+    uint16_t _port;
+    const char* _ssid;
+    const char* _password;
+    ConnectionState _state;
+    StateCallback _callback;
+    NetworkCache _cache;
+    bool _fastConnect;
+    uint32_t _stateSince;
+    uint32_t _backoffMs;
+    uint8_t _attempts;
+    bool _everConnected;
+
+    void _startAttempt();
+    void _startFastAttempt();
+    void _onConnected();
+    void _captureNetworkCache();
+    void _attemptFailed();
+    void _setState(ConnectionState state);
+    void _startServices();
+    void _stopServices();
+};
+
+}
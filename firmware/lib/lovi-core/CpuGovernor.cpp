@@ -0,0 +1,56 @@
+#include "CpuGovernor.h"
+
+extern "C" {
+#include <user_interface.h>
+}
+
+namespace lovi {
+
+CpuGovernor::CpuGovernor(Metrics* metrics)
+    : _metrics(metrics)
+    , _demand(0)
+    , _boostDemand(0)
+    , _boosted(false)
+    , _boostStartMs(0)
+    , _lastDemandMs(0) {
+}
+
+void CpuGovernor::setDemand(uint8_t demand, bool active) {
+    if (active) {
+        _demand |= demand;
+        _lastDemandMs = millis();
+        _boostDemand |= demand;
+        if (!_boosted) {
+            _boost();
+        }
+    } else if (_demand & demand) {
+        _demand &= ~demand;
+        _lastDemandMs = millis();
+    }
+}
+
+void CpuGovernor::update() {
+    if (_boosted && !_demand && millis() - _lastDemandMs >= HOLD_MS) {
+        _release();
+    }
+}
+
+void CpuGovernor::_boost() {
+    system_update_cpu_freq(SYS_CPU_160MHZ);
+    _boosted = true;
+    _boostStartMs = millis();
+    if (_metrics) {
+        _metrics->recordCpuSwitch(BOOST_MHZ, _boostDemand, 0);
+    }
+}
+
+void CpuGovernor::_release() {
+    system_update_cpu_freq(SYS_CPU_80MHZ);
+    _boosted = false;
+    if (_metrics) {
+        _metrics->recordCpuSwitch(BASE_MHZ, _boostDemand, millis() - _boostStartMs);
+    }
+    _boostDemand = 0;
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Metrics.h"
+
+namespace lovi {
+
+// Runs at 80 MHz and raises the clock to 160 MHz while any subsystem
+// reports demanding work. Boosts apply immediately; the drop back waits
+// HOLD_MS so short gaps between bursts do not flap the clock.
+class CpuGovernor {
+public:
+    enum Demand : uint8_t {
+        DEMAND_TLS = 1 << 0,
+        DEMAND_RADAR = 1 << 1,
+        DEMAND_OTA = 1 << 2
+    };
+
+    static const uint8_t BASE_MHZ = 80;
+    static const uint8_t BOOST_MHZ = 160;
+    static const uint32_t HOLD_MS = 1000;
+
+    explicit CpuGovernor(Metrics* metrics = nullptr);
+
+    void setDemand(uint8_t demand, bool active);
+    void update();
+
+    uint8_t getDemand() const { return _demand; }
+    bool isBoosted() const { return _boosted; }
+    uint32_t getActiveBoostMs() const { return _boosted ? millis() - _boostStartMs : 0; }
+
+private:
+    Metrics* _metrics;
+    uint8_t _demand;
+    uint8_t _boostDemand;
+    bool _boosted;
+    uint32_t _boostStartMs;
+    uint32_t _lastDemandMs;
+
+    void _boost();
+    void _release();
+};
+
+}
@@ -1,53 +1,76 @@
 #include "Device.h"
+#include "Log.h"
 
 namespace lovi {
 
-Device::Device(const char* name, DeviceType type, const char* firmwareVersion)
+static uint32_t _fnv1a(uint32_t hash, const void* data, size_t length) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+static bool _outsideDeadband(float value, float reported, float deadband) {
+    return value != reported && fabsf(value - reported) >= deadband;
+}
+
+Device::Device(const char* name, DeviceType type, const char* typeString,
+               const DeviceInfo::Capabilities& capabilities, const char* firmwareVersion)
     : _name(name)
     , _firmwareVersion(firmwareVersion)
     , _type(type)
-    , _mdns(nullptr)
-    , _apiServer(nullptr)
-    , _mdnsStarted(false)
-    , _apiServerStarted(false) {
-    
-    _capabilities.hasPresence = false;
-    _capabilities.hasMotion = false;
-    _capabilities.hasTemperature = false;
-    _capabilities.hasHumidity = false;
-    _capabilities.hasSensitivity = false;
-    _capabilities.maxDistance = 0.0f;
+    , _typeString(typeString)
+    , _capabilities(capabilities)
+    , _capabilitiesHash(0)
+    , _settingsVersion(0)
+    , _settingsPending(false)
+    , _sensorSequence(0)
+    , _changedFields(0)
+    , _dirtyFields(0)
+    , _cpu(&_metrics)
+    , _ota(&_cpu)
+    , _apiServer(this, _identity)
+    , _broadcaster(this, _identity) {
+    _updateCapabilitiesHash();
 }
 
 void Device::begin() {
-    Serial.print("Device initialized: ");
-    Serial.println(_name);
+    _initIdentity();
+    WiFi.hostname(_identity.hostname);
+
+    Log.print("Device initialized: ");
+    Log.print(_identity.hostname);
+    Log.print(" (");
+    Log.print(_identity.macAddress);
+    Log.println(")");
+}
+
+void Device::_initIdentity() {
+    uint8_t* mac = _identity.mac;
+    WiFi.macAddress(mac);
+    snprintf(_identity.macAddress, sizeof(_identity.macAddress), "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    snprintf(_identity.id, sizeof(_identity.id), "%02X%02X%02X%02X%02X%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    // The MAC suffix keeps hostnames unique when several devices share a network.
+    snprintf(_identity.hostname, sizeof(_identity.hostname), "%s-%02X%02X%02X",
+             _name, mac[3], mac[4], mac[5]);
+    _identity.type = getTypeString();
 }
 
 void Device::update() {
-    if (_mdnsStarted && _mdns) {
-        _mdns->update();
-    }
-    if (_apiServerStarted && _apiServer) {
-        _apiServer->update();
-    }
+    _mdns.update();
+    _apiServer.update();
+    _broadcaster.update();
+    sample();
 }
 
 const char* Device::getName() const {
     return _name;
 }
 
-const char* Device::getTypeString() const {
-    switch (_type) {
-        case DeviceType::PRESENCE_GEN_ONE:
-            return "presence_gen_one";
-        case DeviceType::TEST_DEVICE:
-            return "test_device";
-        default:
-            return "unknown";
-    }
-}
-
 const char* Device::getFirmwareVersion() const {
     return _firmwareVersion;
 }
@@ -60,58 +83,137 @@ const SensorData& Device::getSensorData() const {
     return _sensorData;
 }
 
+uint8_t Device::takeDirtyFields() {
+    uint8_t fields = _dirtyFields;
+    _dirtyFields = 0;
+    return fields;
+}
+
+void Device::setSensorDeadbands(const SensorDeadbands& deadbands) {
+    _deadbands = deadbands;
+}
+
+bool Device::applySettings(const DeviceSettings& settings) {
+    DeviceSettings next = settings;
+    next.sensitivity = next.sensitivity > 100 ? 100 : next.sensitivity;
+
+    if (next.sensitivity == _settings.sensitivity
+        && next.ledEnabled == _settings.ledEnabled
+        && next.ledBrightness == _settings.ledBrightness
+        && next.broadcast == _settings.broadcast) {
+        return false;
+    }
+
+    _settings = next;
+    _settingsVersion++;
+    if (_settingsCallback) {
+        _settingsPending = true;
+    }
+    return true;
+}
+
 void Device::_setCapabilities(const DeviceInfo::Capabilities& caps) {
     _capabilities = caps;
+    _updateCapabilitiesHash();
+}
+
+// Covers everything /api/device reports that can differ between builds.
+void Device::_updateCapabilitiesHash() {
+    uint32_t hash = 2166136261UL;
+    hash = _fnv1a(hash, &_capabilities.sensors, sizeof(_capabilities.sensors));
+    hash = _fnv1a(hash, &_capabilities.maxDistance, sizeof(_capabilities.maxDistance));
+    hash = _fnv1a(hash, &_type, sizeof(_type));
+    hash = _fnv1a(hash, _name, strlen(_name));
+    hash = _fnv1a(hash, _firmwareVersion, strlen(_firmwareVersion));
+    _capabilitiesHash = hash;
 }
 
 void Device::_setSensorData(const SensorData& data) {
-    _sensorData = data;
+    uint8_t changed = 0;
+
+    if (data.presence != _sensorData.presence) {
+        _sensorData.presence = data.presence;
+        changed |= SENSOR_PRESENCE;
+    }
+    if (data.motion != _sensorData.motion) {
+        _sensorData.motion = data.motion;
+        changed |= SENSOR_MOTION;
+    }
+    if (_outsideDeadband(data.distance, _sensorData.distance, _deadbands.distance)) {
+        _sensorData.distance = data.distance;
+        changed |= SENSOR_DISTANCE;
+    }
+    if (data.sensitivity != _sensorData.sensitivity) {
+        _sensorData.sensitivity = data.sensitivity;
+        changed |= SENSOR_SENSITIVITY;
+    }
+    if (_outsideDeadband(data.temperature, _sensorData.temperature, _deadbands.temperature)) {
+        _sensorData.temperature = data.temperature;
+        changed |= SENSOR_TEMPERATURE;
+    }
+    if (_outsideDeadband(data.humidity, _sensorData.humidity, _deadbands.humidity)) {
+        _sensorData.humidity = data.humidity;
+        changed |= SENSOR_HUMIDITY;
+    }
+    if (data.uptime < _sensorData.uptime
+        || data.uptime - _sensorData.uptime >= _deadbands.uptime) {
+        _sensorData.uptime = data.uptime;
+        changed |= SENSOR_UPTIME;
+    }
+
+    if (changed) {
+        uint32_t timeMs = millis();
+        if (data.edgeTimeUs && (changed & (SENSOR_PRESENCE | SENSOR_MOTION))) {
+            timeMs -= (micros() - data.edgeTimeUs) / 1000;
+        }
+        _sensorData.edgeTimeUs = data.edgeTimeUs;
+
+        _sensorSequence++;
+        _changedFields = changed;
+        _dirtyFields |= changed;
+        _history.record(_sensorSequence, _sensorData, changed, timeMs);
+    }
 }
 
 void Device::startMDNS(uint16_t port) {
-    if (!_mdnsStarted) {
-        _mdns = new MDNSAdvertiser();
-        _mdns->begin(_name, _firmwareVersion, port);
-        _mdnsStarted = true;
-    }
+    _mdns.begin(_identity, _firmwareVersion, port);
 }
 
 void Device::updateMDNS() {
-    if (_mdns) {
-        _mdns->update();
-    }
+    _mdns.update();
 }
 
 void Device::stopMDNS() {
-    if (_mdns) {
-        _mdns->stop();
-        delete _mdns;
-        _mdns = nullptr;
-    }
-    _mdnsStarted = false;
+    _mdns.stop();
 }
 
 void Device::startAPIServer(uint16_t port) {
-    if (!_apiServerStarted) {
-        _apiServer = new APIServer(this, port);
-        _apiServer->begin();
-        _apiServerStarted = true;
-    }
+    _apiServer.begin(port);
 }
 
 void Device::updateAPIServer() {
-    if (_apiServer) {
-        _apiServer->update();
+    _apiServer.update();
+    _ota.update();
+    if (_settingsPending) {
+        _settingsPending = false;
+        _settingsCallback(_settings);
     }
 }
 
 void Device::stopAPIServer() {
-    if (_apiServer) {
-        _apiServer->stop();
-        delete _apiServer;
-        _apiServer = nullptr;
-    }
-    _apiServerStarted = false;
+    _apiServer.stop();
+}
+
+void Device::startBroadcast() {
+    _broadcaster.begin();
+}
+
+void Device::updateBroadcast() {
+    _broadcaster.update();
+}
+
+void Device::stopBroadcast() {
+    _broadcaster.stop();
 }
 
 }
@@ -2,49 +2,126 @@
 
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
+#include <functional>
 #include "types.h"
+#include "DeviceTraits.h"
 #include "MDNSAdvertiser.h"
 #include "APIServer.h"
+#include "StateBroadcaster.h"
+#include "Metrics.h"
+#include "CpuGovernor.h"
+#include "OtaUpdater.h"
+#include "History.h"
 
 namespace lovi {
 
 class Device {
 public:
-    Device(const char* name, DeviceType type, const char* firmwareVersion);
+    Device(const char* name, DeviceType type, const char* typeString,
+           const DeviceInfo::Capabilities& capabilities, const char* firmwareVersion);
     virtual ~Device() = default;
 
     virtual void begin();
     virtual void update();
+    virtual void sample() {}
+    // Called around a firmware update so models can quiesce their inputs.
+    virtual void pauseSampling() {}
+    virtual void resumeSampling() {}
 
     const char* getName() const;
-    const char* getTypeString() const;
+    const char* getTypeString() const { return _typeString; }
+    const DeviceIdentity& getIdentity() const { return _identity; }
     DeviceType getType() const { return _type; }
     const char* getFirmwareVersion() const;
     const DeviceInfo::Capabilities& getCapabilities() const;
+    uint32_t getCapabilitiesHash() const { return _capabilitiesHash; }
     const SensorData& getSensorData() const;
+    uint32_t getSensorSequence() const { return _sensorSequence; }
+    uint8_t getChangedFields() const { return _changedFields; }
+    uint8_t takeDirtyFields();
+
+    const SensorDeadbands& getSensorDeadbands() const { return _deadbands; }
+    void setSensorDeadbands(const SensorDeadbands& deadbands);
+
+    typedef std::function<void(const DeviceSettings&)> SettingsCallback;
+
+    const DeviceSettings& getSettings() const { return _settings; }
+    uint32_t getSettingsVersion() const { return _settingsVersion; }
+    bool applySettings(const DeviceSettings& settings);
+    // Runs from updateAPIServer() rather than applySettings(): the async HTTP
+    // backend applies settings in TCP callbacks, where flash writes must not run.
+    void onSettingsChange(SettingsCallback callback) { _settingsCallback = callback; }
+
+    Metrics& getMetrics() { return _metrics; }
+    CpuGovernor& getCpuGovernor() { return _cpu; }
+    OtaUpdater& getOtaUpdater() { return _ota; }
+    const History& getHistory() const { return _history; }
 
     void startMDNS(uint16_t port = 80);
     void updateMDNS();
     void stopMDNS();
+    bool setMdnsTxt(const char* key, const char* value) { return _mdns.setTxt(key, value); }
 
+    void setApiKey(const char* apiKey) { _apiServer.setApiKey(apiKey); }
+#if LOVI_TLS
+    bool setCertificate(const char* certPem, const char* keyPem) {
+        return _apiServer.setCertificate(certPem, keyPem);
+    }
+#endif
     void startAPIServer(uint16_t port = 80);
     void updateAPIServer();
     void stopAPIServer();
 
+    void startBroadcast();
+    void updateBroadcast();
+    void stopBroadcast();
+
 protected:
     void _setCapabilities(const DeviceInfo::Capabilities& caps);
+    void _updateCapabilitiesHash();
     void _setSensorData(const SensorData& data);
+    void _initIdentity();
 
 private:
     const char* _name;
     const char* _firmwareVersion;
     DeviceType _type;
+    const char* _typeString;
+    DeviceIdentity _identity;
     DeviceInfo::Capabilities _capabilities;
+    uint32_t _capabilitiesHash;
     SensorData _sensorData;
-    MDNSAdvertiser* _mdns;
-    APIServer* _apiServer;
-    bool _mdnsStarted;
-    bool _apiServerStarted;
+    SensorDeadbands _deadbands;
+    DeviceSettings _settings;
+    uint32_t _settingsVersion;
+    SettingsCallback _settingsCallback;
+    bool _settingsPending;
+    uint32_t _sensorSequence;
+    uint8_t _changedFields;
+    uint8_t _dirtyFields;
+    Metrics _metrics;
+    History _history;
+    CpuGovernor _cpu;
+    OtaUpdater _ota;
+    MDNSAdvertiser _mdns;
+    APIServer _apiServer;
+    StateBroadcaster _broadcaster;
+};
+
+// Base for concrete models: the type string and capabilities come from
+// DeviceTraits, and has<>() lets sampling code drop absent sensors at
+// compile time.
+template <DeviceType Type>
+class DeviceModel : public Device {
+public:
+    typedef DeviceTraits<Type> Traits;
+
+    template <uint8_t Field>
+    static constexpr bool has() { return (Traits::SENSORS & Field) != 0; }
+
+protected:
+    DeviceModel(const char* name, const char* firmwareVersion)
+        : Device(name, Type, Traits::TYPE_STRING, capabilitiesOf<Traits>(), firmwareVersion) {}
 };
 
 }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "types.h"
+
+namespace lovi {
+
+// Compile-time description of a Lovi model. Adding a model means adding a
+// DeviceType and a specialization here; capabilities, the type string and
+// which sensors get sampled and serialized all follow from these constants.
+template <DeviceType Type>
+struct DeviceTraits;
+
+template <>
+struct DeviceTraits<DeviceType::PRESENCE_GEN_ONE> {
+    static constexpr const char* TYPE_STRING = "presence_gen_one";
+    static constexpr uint8_t SENSORS = SENSOR_PRESENCE | SENSOR_MOTION | SENSOR_DISTANCE
+        | SENSOR_SENSITIVITY | SENSOR_TEMPERATURE | SENSOR_HUMIDITY | SENSOR_UPTIME;
+    static constexpr float MAX_DISTANCE = 5.0f;
+};
+
+template <>
+struct DeviceTraits<DeviceType::TEST_DEVICE> {
+    static constexpr const char* TYPE_STRING = "test_device";
+    static constexpr uint8_t SENSORS = SENSOR_UPTIME;
+    static constexpr float MAX_DISTANCE = 0.0f;
+};
+
+template <typename Traits>
+constexpr DeviceInfo::Capabilities capabilitiesOf() {
+    return DeviceInfo::Capabilities{Traits::SENSORS, Traits::MAX_DISTANCE};
+}
+
+}
@@ -0,0 +1,113 @@
+#include "History.h"
+
+namespace lovi {
+
+History::History()
+    : _head(0)
+    , _count(0)
+    , _oldestSequence(0)
+    , _oldestTimeMs(0)
+    , _newestTimeMs(0) {
+}
+
+void History::clear() {
+    _head = 0;
+    _count = 0;
+}
+
+void History::record(uint32_t sequence, const SensorData& data, uint8_t changedFields, uint32_t timeMs) {
+    // Entries must stay consecutive so sequence numbers can be implied.
+    if (_count > 0 && sequence != getNewestSequence() + 1) {
+        clear();
+    }
+
+    uint32_t delta = 0;
+    if (_count == 0) {
+        _oldestSequence = sequence;
+        _oldestTimeMs = timeMs;
+    } else {
+        // Back-dated entries share the newest timestamp, so time never runs
+        // backwards; the signed difference also survives millis() wrapping.
+        int32_t elapsedMs = static_cast<int32_t>(timeMs - _newestTimeMs);
+        delta = elapsedMs > 0 ? elapsedMs / 100 : 0;
+        if (delta > 0xFFFF) {
+            delta = 0xFFFF;
+        }
+    }
+
+    float centimetres = data.distance * 100.0f + 0.5f;
+    uint32_t distance = centimetres <= 0.0f ? 0 : static_cast<uint32_t>(centimetres);
+    if (distance > 0xFFF) {
+        distance = 0xFFF;
+    }
+
+    uint32_t packed = (delta << 16)
+        | (distance << 4)
+        | ((changedFields & SENSOR_MOTION) ? 0x08 : 0)
+        | ((changedFields & SENSOR_PRESENCE) ? 0x04 : 0)
+        | (data.motion ? 0x02 : 0)
+        | (data.presence ? 0x01 : 0);
+
+    if (_count == CAPACITY) {
+        // Drop the oldest entry; its successor becomes the new time base.
+        _head = (_head + 1) % CAPACITY;
+        _count--;
+        _oldestSequence++;
+        _oldestTimeMs += _timeDeltaMs(_at(0));
+    }
+
+    _entries[(_head + _count) % CAPACITY] = packed;
+    _count++;
+    // Track the quantized time so saturated or rounded deltas do not drift.
+    _newestTimeMs = _count == 1 ? timeMs : _newestTimeMs + delta * 100;
+}
+
+History::Cursor History::since(uint32_t sinceSequence) const {
+    if (_count == 0 || sinceSequence >= getNewestSequence()) {
+        return Cursor(this, _count, 0);
+    }
+
+    size_t offset = 0;
+    if (sinceSequence >= _oldestSequence) {
+        offset = sinceSequence - _oldestSequence + 1;
+    }
+
+    uint32_t timeMs = _oldestTimeMs;
+    for (size_t i = 1; i <= offset; i++) {
+        timeMs += _timeDeltaMs(_at(i));
+    }
+    return Cursor(this, offset, timeMs);
+}
+
+History::Cursor::Cursor(const History* history, size_t offset, uint32_t timeMs)
+    : _history(history)
+    , _offset(offset)
+    , _timeMs(timeMs) {
+}
+
+bool History::Cursor::next(HistoryEntry& entry) {
+    if (_offset >= _history->_count) {
+        return false;
+    }
+
+    uint32_t packed = _history->_at(_offset);
+    _unpack(packed, entry);
+    entry.sequence = _history->_oldestSequence + _offset;
+    entry.timeMs = _timeMs;
+
+    _offset++;
+    if (_offset < _history->_count) {
+        _timeMs += _timeDeltaMs(_history->_at(_offset));
+    }
+    return true;
+}
+
+void History::_unpack(uint32_t packed, HistoryEntry& entry) {
+    entry.presence = packed & 0x01;
+    entry.motion = packed & 0x02;
+    entry.presenceEdge = packed & 0x04;
+    entry.motionEdge = packed & 0x08;
+    entry.distance = ((packed >> 4) & 0xFFF) / 100.0f;
+}
+
+}
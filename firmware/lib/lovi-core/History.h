@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include "types.h"
+
+#ifndef LOVI_HISTORY_CAPACITY
+#define LOVI_HISTORY_CAPACITY 2048
+#endif
+
+namespace lovi {
+
+struct HistoryEntry {
+    uint32_t sequence;
+    uint32_t timeMs;
+    bool presence;
+    bool motion;
+    bool presenceEdge;
+    bool motionEdge;
+    float distance;
+};
+
+// Statically allocated ring of sensor state changes, one per sequence number.
+// Each entry packs into 32 bits:
+//   [31:16] time since previous entry (100 ms units, saturating)
+//   [15:4]  distance (cm, saturating)
+//   [3] motion edge  [2] presence edge  [1] motion  [0] presence
+class History {
+public:
+    static const size_t CAPACITY = LOVI_HISTORY_CAPACITY;
+
+    History();
+
+    void record(uint32_t sequence, const SensorData& data, uint8_t changedFields, uint32_t timeMs);
+    void clear();
+
+    size_t size() const { return _count; }
+    bool isEmpty() const { return _count == 0; }
+    uint32_t getOldestSequence() const { return _oldestSequence; }
+    uint32_t getNewestSequence() const { return _oldestSequence + _count - 1; }
+
+    class Cursor {
+    public:
+        bool next(HistoryEntry& entry);
+
+    private:
+        friend class History;
+        Cursor(const History* history, size_t offset, uint32_t timeMs);
+
+        const History* _history;
+        size_t _offset;
+        uint32_t _timeMs;
+    };
+
+    // Cursor over entries with a sequence number greater than sinceSequence.
+    Cursor since(uint32_t sinceSequence) const;
+
+private:
+    uint32_t _entries[CAPACITY];
+    size_t _head;
+    size_t _count;
+    uint32_t _oldestSequence;
+    uint32_t _oldestTimeMs;
+    uint32_t _newestTimeMs;
+
+    uint32_t _at(size_t offset) const { return _entries[(_head + offset) % CAPACITY]; }
+    static uint32_t _timeDeltaMs(uint32_t packed) { return (packed >> 16) * 100; }
+    static void _unpack(uint32_t packed, HistoryEntry& entry);
+};
+
+}
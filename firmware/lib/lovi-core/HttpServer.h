@@ -0,0 +1,37 @@
+#pragma once
+
+// Selects the HTTP backend APIServer is built on. The synchronous backend
+// wraps ESP8266WebServer and serves one client per handleClient() call;
+// build with -DLOVI_ASYNC_HTTP=1 (and ESPAsyncWebServer/ESPAsyncTCP in
+// lib_deps) to serve requests from the TCP stack's callbacks instead.
+#ifndef LOVI_ASYNC_HTTP
+#define LOVI_ASYNC_HTTP 0
+#endif
+
+// -DLOVI_TLS=1 serves the API over HTTPS with BearSSL. ESPAsyncTCP has no
+// usable TLS server, so this is only available on the synchronous backend.
+#ifndef LOVI_TLS
+#define LOVI_TLS 0
+#endif
+
+#if LOVI_TLS && LOVI_ASYNC_HTTP
+#error "LOVI_TLS requires the synchronous HTTP backend"
+#endif
+
+#if LOVI_ASYNC_HTTP
+#include "AsyncHttpServer.h"
+#else
+#include "SyncHttpServer.h"
+#endif
+
+namespace lovi {
+
+#if LOVI_ASYNC_HTTP
+using HttpServer = AsyncHttpServer;
+using HttpRequest = AsyncHttpRequest;
+#else
+using HttpServer = SyncHttpServer;
+using HttpRequest = SyncHttpRequest;
+#endif
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace lovi {
+
+// One step of a multipart file upload, as delivered by either HTTP backend.
+// START and END carry no data; ABORTED means the client went away.
+struct HttpUploadChunk {
+    enum Status : uint8_t { START, WRITE, END, ABORTED };
+
+    Status status;
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+};
+
+}
@@ -0,0 +1,85 @@
+#include "InputCapture.h"
+
+namespace lovi {
+
+InputCapture::InputCapture()
+    : _lineCount(0)
+    , _started(false)
+    , _dropped(0) {
+}
+
+InputCapture::~InputCapture() {
+    end();
+}
+
+int8_t InputCapture::addLine(uint8_t pin, bool activeHigh) {
+    if (_lineCount >= MAX_LINES || _started) {
+        return -1;
+    }
+
+    Line& line = _lines[_lineCount];
+    line.owner = this;
+    line.index = _lineCount;
+    line.pin = pin;
+    line.activeHigh = activeHigh;
+    line.active = false;
+    return _lineCount++;
+}
+
+void InputCapture::begin() {
+    if (_started) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _lineCount; i++) {
+        Line& line = _lines[i];
+        pinMode(line.pin, INPUT);
+        line.active = (digitalRead(line.pin) == HIGH) == line.activeHigh;
+        attachInterruptArg(digitalPinToInterrupt(line.pin), _onEdge, &line, CHANGE);
+    }
+    _started = true;
+}
+
+void InputCapture::end() {
+    if (!_started) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _lineCount; i++) {
+        detachInterrupt(digitalPinToInterrupt(_lines[i].pin));
+    }
+    _started = false;
+}
+
+bool InputCapture::poll(InputEdge& edge) {
+    if (!_queue.pop(edge)) {
+        return false;
+    }
+    _lines[edge.line].active = edge.active;
+    return true;
+}
+
+bool InputCapture::isActive(uint8_t line) const {
+    return line < _lineCount && _lines[line].active;
+}
+
+void IRAM_ATTR InputCapture::_onEdge(void* arg) {
+    Line* line = static_cast<Line*>(arg);
+
+    // A light sleep wake source switches the pin to a level trigger, which
+    // would keep firing; put back the edge trigger this line was attached with.
+    if (((GPC(line->pin) >> GPCI) & 7) != CHANGE) {
+        GPC(line->pin) = (GPC(line->pin) & ~(7 << GPCI)) | (CHANGE << GPCI);
+    }
+
+    InputEdge edge;
+    edge.timeUs = micros();
+    edge.line = line->index;
+    edge.active = (digitalRead(line->pin) == HIGH) == line->activeHigh;
+
+    if (!line->owner->_queue.push(edge)) {
+        line->owner->_dropped = line->owner->_dropped + 1;
+    }
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "SpscQueue.h"
+
+namespace lovi {
+
+struct InputEdge {
+    uint32_t timeUs;
+    uint8_t line;
+    bool active;
+};
+
+// Timestamps GPIO edges in interrupt context and hands them to the main
+// loop through a lock-free queue, so edge timing no longer depends on how
+// long the rest of the loop takes.
+class InputCapture {
+public:
+    static const uint8_t MAX_LINES = 4;
+    static const size_t QUEUE_SIZE = 32;
+
+    InputCapture();
+    ~InputCapture();
+
+    // Returns the line index, or -1 when all lines are in use.
+    int8_t addLine(uint8_t pin, bool activeHigh = true);
+    void begin();
+    void end();
+
+    bool poll(InputEdge& edge);
+    bool isActive(uint8_t line) const;
+    bool hasPending() const { return !_queue.isEmpty(); }
+    uint32_t getDroppedCount() const { return _dropped; }
+
+private:
+    struct Line {
+        InputCapture* owner;
+        uint8_t index;
+        uint8_t pin;
+        bool activeHigh;
+        bool active;
+    };
+
+    Line _lines[MAX_LINES];
+    uint8_t _lineCount;
+    bool _started;
+    SpscQueue<InputEdge, QUEUE_SIZE> _queue;
+    volatile uint32_t _dropped;
+
+    static void _onEdge(void* arg);
+};
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Diagnostic output. Devices whose radar owns UART0 build with
+// -DLOVI_LOG_UART1=1 to log on UART1's TX-only pin (GPIO2) instead.
+#ifndef LOVI_LOG_UART1
+#define LOVI_LOG_UART1 0
+#endif
+
+namespace lovi {
+
+#if LOVI_LOG_UART1
+static Print& Log = Serial1;
+#else
+static Print& Log = Serial;
+#endif
+
+}
@@ -1,58 +1,138 @@
 #include "MDNSAdvertiser.h"
+#include "Log.h"
 
 namespace lovi {
 
-MDNSAdvertiser::MDNSAdvertiser() : _started(false) {
+MDNSAdvertiser::MDNSAdvertiser()
+    : _identity(nullptr)
+    , _firmwareVersion("")
+    , _port(80)
+    , _service(nullptr)
+    , _txtCount(0)
+    , _scheduled(false)
+    , _started(false)
+    , _announcePending(false)
+    , _startAtMs(0)
+    , _lastAnnounceMs(0)
+    , _nextUpdateMs(0) {
 }
 
-void MDNSAdvertiser::begin(const char* deviceName, const char* firmwareVersion, uint16_t port) {
-    if (_started) {
+void MDNSAdvertiser::begin(const DeviceIdentity& identity, const char* firmwareVersion, uint16_t port) {
+    if (_started || _scheduled) {
         return;
     }
 
-    if (MDNS.begin(deviceName)) {
-        Serial.print("mDNS started: ");
-        Serial.print(deviceName);
-        Serial.println(".local");
-
-        MDNS.addService("lovi", "tcp", port);
-        _setDeviceProperties(firmwareVersion);
+    _identity = &identity;
+    _firmwareVersion = firmwareVersion;
+    _port = port;
+    _startAtMs = millis() + ESP.random() % START_JITTER_MS;
+    _scheduled = true;
+}
 
-        Serial.println("mDNS service advertised");
-        _started = true;
-    } else {
-        Serial.println("Failed to start mDNS");
+void MDNSAdvertiser::_start() {
+    if (!MDNS.begin(_identity->hostname)) {
+        Log.println("Failed to start mDNS");
+        return;
     }
+
+    Log.print("mDNS started: ");
+    Log.print(_identity->hostname);
+    Log.println(".local");
+
+    _service = MDNS.addService(nullptr, "lovi", "tcp", _port);
+    _setDeviceProperties();
+    // Dynamic records are rebuilt for every response and announcement.
+    MDNS.setDynamicServiceTxtCallback(_service, [this](MDNSResponder::hMDNSService service) {
+        _addDynamicTxt(service);
+    });
+
+    Log.println("mDNS service advertised");
+    _started = true;
+    // The responder announces on its own after probing.
+    _announcePending = false;
+    _lastAnnounceMs = millis();
+    _nextUpdateMs = _lastAnnounceMs;
 }
 
 void MDNSAdvertiser::update() {
-    if (_started) {
-        MDNS.update();
+    uint32_t now = millis();
+    if (_scheduled && static_cast<int32_t>(now - _startAtMs) >= 0) {
+        _scheduled = false;
+        _start();
+    }
+    if (!_started || static_cast<int32_t>(now - _nextUpdateMs) < 0) {
+        return;
+    }
+
+    if (_announcePending && now - _lastAnnounceMs >= ANNOUNCE_MIN_INTERVAL_MS) {
+        MDNS.announce();
+        _announcePending = false;
+        _lastAnnounceMs = now;
+    }
+
+    uint32_t start = micros();
+    MDNS.update();
+    uint32_t waitMs = (micros() - start) / 1000 * UPDATE_BUDGET_DIVISOR;
+    if (waitMs < UPDATE_INTERVAL_MS) {
+        waitMs = UPDATE_INTERVAL_MS;
     }
+    _nextUpdateMs = millis() + waitMs;
 }
 
 void MDNSAdvertiser::stop() {
-    _started = false;
+    _scheduled = false;
+    if (_started) {
+        // Removing the service sends its goodbye (TTL 0) before the responder goes down.
+        MDNS.removeService(_service);
+        MDNS.end();
+        _service = nullptr;
+        _started = false;
+        _announcePending = false;
+        Log.println("mDNS stopped");
+    }
 }
 
-void MDNSAdvertiser::_setDeviceProperties(const char* firmwareVersion) {
-    String mac = _getMACAddress();
-    String model = "Lovi Device";
-    String deviceType = "presence_gen_one";
+bool MDNSAdvertiser::setTxt(const char* key, const char* value) {
+    TxtRecord* record = nullptr;
+    for (uint8_t i = 0; i < _txtCount; i++) {
+        if (strcmp(_txt[i].key, key) == 0) {
+            record = &_txt[i];
+            break;
+        }
+    }
 
-    MDNS.addServiceTxt("lovi", "tcp", "mac", mac);
-    MDNS.addServiceTxt("lovi", "tcp", "model", model);
-    MDNS.addServiceTxt("lovi", "tcp", "device_type", deviceType);
-    MDNS.addServiceTxt("lovi", "tcp", "firmware_version", firmwareVersion);
+    if (!record) {
+        if (_txtCount == MAX_DYNAMIC_TXT) {
+            return false;
+        }
+        record = &_txt[_txtCount++];
+        strncpy(record->key, key, sizeof(record->key) - 1);
+        record->key[sizeof(record->key) - 1] = '\0';
+        record->value[0] = '\0';
+    } else if (strncmp(record->value, value, sizeof(record->value) - 1) == 0) {
+        return true;
+    }
+
+    strncpy(record->value, value, sizeof(record->value) - 1);
+    record->value[sizeof(record->value) - 1] = '\0';
+    _announcePending = _started;
+    return true;
 }
 
-String MDNSAdvertiser::_getMACAddress() {
-    uint8_t mac[6];
-    WiFi.macAddress(mac);
-    char buffer[18];
-    snprintf(buffer, sizeof(buffer), "%02X:%02X:%02X:%02X:%02X:%02X",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
-    return String(buffer);
+void MDNSAdvertiser::_setDeviceProperties() {
+    MDNS.addServiceTxt(_service, "mac", _identity->macAddress);
+    MDNS.addServiceTxt(_service, "model", "Lovi Device");
+    MDNS.addServiceTxt(_service, "device_type", _identity->type);
+    MDNS.addServiceTxt(_service, "firmware_version", _firmwareVersion);
+#if LOVI_TLS
+    MDNS.addServiceTxt(_service, "tls", "1");
+#endif
+}
+
+void MDNSAdvertiser::_addDynamicTxt(MDNSResponder::hMDNSService service) {
+    for (uint8_t i = 0; i < _txtCount; i++) {
+        MDNS.addDynamicServiceTxt(service, _txt[i].key, _txt[i].value);
+    }
 }
 
 }
@@ -3,23 +3,60 @@
 #include <Arduino.h>
 #include <ESP8266WiFi.h>
 #include <ESP8266mDNS.h>
+#include "types.h"
 
 namespace lovi {
 
+// Advertises _lovi._tcp with fixed identity records plus a few dynamic TXT
+// records that can change at runtime. Changes are coalesced into at most
+// one re-announcement per ANNOUNCE_MIN_INTERVAL_MS, the responder start is
+// jittered so a segment of devices powering up together does not probe in
+// lockstep, and stop() withdraws the service with a goodbye.
 class MDNSAdvertiser {
 public:
+    static const uint8_t MAX_DYNAMIC_TXT = 4;
+    static const size_t TXT_KEY_SIZE = 16;
+    static const size_t TXT_VALUE_SIZE = 32;
+    static const uint32_t ANNOUNCE_MIN_INTERVAL_MS = 5000;
+    static const uint32_t START_JITTER_MS = 2000;
+    static const uint32_t UPDATE_INTERVAL_MS = 50;
+    // MDNS.update() gets at most 1/N of the time between calls.
+    static const uint8_t UPDATE_BUDGET_DIVISOR = 10;
+
     MDNSAdvertiser();
     ~MDNSAdvertiser() = default;
 
-    void begin(const char* deviceName, const char* firmwareVersion, uint16_t port = 80);
+    void begin(const DeviceIdentity& identity, const char* firmwareVersion, uint16_t port = 80);
 
     void update();
     void stop();
 
+    // Adds or changes a dynamic TXT record; false if the table is full.
+    bool setTxt(const char* key, const char* value);
+    bool isStarted() const { return _started; }
+
 private:
-    void _setDeviceProperties(const char* firmwareVersion);
-    String _getMACAddress();
+    struct TxtRecord {
+        char key[TXT_KEY_SIZE];
+        char value[TXT_VALUE_SIZE];
+    };
+
+    void _start();
+    void _setDeviceProperties();
+    void _addDynamicTxt(MDNSResponder::hMDNSService service);
+
+    const DeviceIdentity* _identity;
+    const char* _firmwareVersion;
+    uint16_t _port;
+    MDNSResponder::hMDNSService _service;
+    TxtRecord _txt[MAX_DYNAMIC_TXT];
+    uint8_t _txtCount;
+    bool _scheduled;
     bool _started;
+    bool _announcePending;
+    uint32_t _startAtMs;
+    uint32_t _lastAnnounceMs;
+    uint32_t _nextUpdateMs;
 };
 
 }
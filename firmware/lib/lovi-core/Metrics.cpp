@@ -0,0 +1,85 @@
+#include "Metrics.h"
+
+extern "C" {
+#include <user_interface.h>
+}
+
+namespace lovi {
+
+void LatencyStats::record(uint32_t us) {
+    if (count == 0 || us < minUs) {
+        minUs = us;
+    }
+    if (us > maxUs) {
+        maxUs = us;
+    }
+    count++;
+    totalUs += us;
+
+    uint8_t bucket = 0;
+    while (bucket < BUCKETS - 1 && us >= bucketLimitUs(bucket)) {
+        bucket++;
+    }
+    histogram[bucket]++;
+}
+
+Metrics::Metrics()
+    : _probeCount(0)
+    , _requests(0)
+    , _notModified(0)
+    , _notFound(0)
+    , _dutyPermille(1000)
+    , _busyUs(0)
+    , _idleUs(0)
+    , _powerMode("performance")
+    , _cpuBoosts(0)
+    , _cpuBoostedMs(0)
+    , _cpuLastDemand(0)
+    , _cpuLastSwitchMs(0) {
+}
+
+int8_t Metrics::addProbe(const char* name) {
+    if (_probeCount >= MAX_PROBES) {
+        return -1;
+    }
+    _probeNames[_probeCount] = name;
+    _probes[_probeCount] = LatencyStats();
+    return _probeCount++;
+}
+
+void Metrics::record(int8_t probe, uint32_t cycles) {
+    if (probe < 0 || probe >= _probeCount) {
+        return;
+    }
+    // ESP.getCpuFreqMHz() is the build-time F_CPU; CpuGovernor switches the
+    // clock at runtime.
+    _probes[probe].record(cycles / system_get_cpu_freq());
+}
+
+void Metrics::recordDutyCycle(uint32_t busyUs, uint32_t windowUs) {
+    if (windowUs == 0 || busyUs > windowUs) {
+        return;
+    }
+    _dutyPermille = static_cast<uint16_t>(static_cast<uint64_t>(busyUs) * 1000 / windowUs);
+    _busyUs += busyUs;
+    _idleUs += windowUs - busyUs;
+}
+
+void Metrics::recordCpuSwitch(uint8_t mhz, uint8_t demand, uint32_t boostedMs) {
+    if (mhz > 80) {
+        _cpuBoosts++;
+    }
+    _cpuBoostedMs += boostedMs;
+    _cpuLastDemand = demand;
+    _cpuLastSwitchMs = millis();
+}
+
+const char* Metrics::getProbeName(uint8_t probe) const {
+    return probe < _probeCount ? _probeNames[probe] : nullptr;
+}
+
+const LatencyStats* Metrics::getProbeStats(uint8_t probe) const {
+    return probe < _probeCount ? &_probes[probe] : nullptr;
+}
+
+}
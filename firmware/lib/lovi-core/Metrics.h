@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace lovi {
+
+struct LatencyStats {
+    // Bucket i counts samples below 16 << (2 * i) us; the last is open-ended.
+    static const uint8_t BUCKETS = 8;
+
+    uint32_t count = 0;
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+    uint32_t histogram[BUCKETS] = {0};
+
+    void record(uint32_t us);
+    uint32_t meanUs() const { return count ? totalUs / count : 0; }
+    static uint32_t bucketLimitUs(uint8_t bucket) { return 16UL << (2 * bucket); }
+};
+
+class Metrics {
+public:
+    static const uint8_t MAX_PROBES = 8;
+
+    Metrics();
+
+    int8_t addProbe(const char* name);
+    void record(int8_t probe, uint32_t cycles);
+
+    uint8_t getProbeCount() const { return _probeCount; }
+    const char* getProbeName(uint8_t probe) const;
+    const LatencyStats* getProbeStats(uint8_t probe) const;
+
+    void countRequest() { _requests++; }
+    void countNotModified() { _notModified++; }
+    void countNotFound() { _notFound++; }
+    uint32_t getRequestCount() const { return _requests; }
+    uint32_t getNotModifiedCount() const { return _notModified; }
+    uint32_t getNotFoundCount() const { return _notFound; }
+
+    void recordDutyCycle(uint32_t busyUs, uint32_t windowUs);
+    uint16_t getDutyCyclePermille() const { return _dutyPermille; }
+    uint32_t getBusyMs() const { return _busyUs / 1000; }
+    uint32_t getIdleMs() const { return _idleUs / 1000; }
+    void setPowerMode(const char* mode) { _powerMode = mode; }
+    const char* getPowerMode() const { return _powerMode; }
+
+    // demand is the CpuGovernor mask that caused (or was held by) the boost.
+    void recordCpuSwitch(uint8_t mhz, uint8_t demand, uint32_t boostedMs);
+    uint32_t getCpuBoostCount() const { return _cpuBoosts; }
+    uint32_t getCpuBoostedMs() const { return _cpuBoostedMs; }
+    uint8_t getCpuLastDemand() const { return _cpuLastDemand; }
+    uint32_t getCpuLastSwitchMs() const { return _cpuLastSwitchMs; }
+
+private:
+    const char* _probeNames[MAX_PROBES];
+    LatencyStats _probes[MAX_PROBES];
+    uint8_t _probeCount;
+    uint32_t _requests;
+    uint32_t _notModified;
+    uint32_t _notFound;
+    uint16_t _dutyPermille;
+    uint64_t _busyUs;
+    uint64_t _idleUs;
+    const char* _powerMode;
+    uint32_t _cpuBoosts;
+    uint32_t _cpuBoostedMs;
+    uint8_t _cpuLastDemand;
+    uint32_t _cpuLastSwitchMs;
+};
+
+}
@@ -0,0 +1,161 @@
+#include "OtaUpdater.h"
+#include "Log.h"
+#include <Updater.h>
+
+namespace lovi {
+
+OtaUpdater::OtaUpdater(CpuGovernor* cpu)
+    : _cpu(cpu)
+    , _state(OtaState::IDLE)
+    , _size(0)
+    , _written(0)
+    , _lastWriteMs(0)
+    , _finishedMs(0)
+    , _reportedDecile(0)
+    , _error(nullptr) {
+}
+
+bool OtaUpdater::begin(uint32_t size, const char* md5) {
+    if (isActive()) {
+        return false;
+    }
+
+    _size = size;
+    _written = 0;
+    _reportedDecile = 0;
+    _error = nullptr;
+    _lastWriteMs = millis();
+
+    // Without a size, reserve the whole spare partition and accept whatever arrives.
+    // Less than a sector free must read as no space, not wrap around.
+    uint32_t freeSpace = ESP.getFreeSketchSpace();
+    uint32_t space = freeSpace > 0x1000 ? (freeSpace - 0x1000) & ~0xFFFu : 0;
+    if (size > space) {
+        _fail("Image too large");
+        return false;
+    }
+    if (!md5 || strlen(md5) != 32) {
+        _fail("Missing MD5");
+        return false;
+    }
+
+    // No yields mid-write, so upload data cannot arrive while a chunk is written.
+    Update.runAsync(true);
+    if (!Update.begin(size ? size : space) || !Update.setMD5(md5)) {
+        Update.end(false);
+        _fail("Cannot start update");
+        return false;
+    }
+
+    if (_cpu) {
+        _cpu->setDemand(CpuGovernor::DEMAND_OTA, true);
+    }
+    Log.print("OTA started, ");
+    Log.print(size);
+    Log.println(" bytes");
+    _setState(OtaState::RECEIVING);
+    return true;
+}
+
+bool OtaUpdater::write(const uint8_t* data, size_t length) {
+    if (!isActive()) {
+        return false;
+    }
+    if (Update.write(const_cast<uint8_t*>(data), length) != length) {
+        _fail("Flash write failed");
+        return false;
+    }
+
+    _written += length;
+    _lastWriteMs = millis();
+
+    uint8_t decile = getProgress() / 10;
+    if (_size && decile > _reportedDecile) {
+        _reportedDecile = decile;
+        Log.print("OTA ");
+        Log.print(decile * 10);
+        Log.println("%");
+    }
+    return true;
+}
+
+bool OtaUpdater::end() {
+    if (!isActive()) {
+        return false;
+    }
+    if (_size && _written != _size) {
+        _fail("Image truncated");
+        return false;
+    }
+    if (!Update.end(_size == 0)) {
+        _fail("Image verification failed");
+        return false;
+    }
+
+    if (_cpu) {
+        _cpu->setDemand(CpuGovernor::DEMAND_OTA, false);
+    }
+    _finishedMs = millis();
+    Log.println("OTA complete, rebooting");
+    _setState(OtaState::SUCCESS);
+    return true;
+}
+
+void OtaUpdater::abort(const char* reason) {
+    if (isActive()) {
+        _fail(reason);
+    }
+}
+
+void OtaUpdater::update() {
+    if (isActive() && millis() - _lastWriteMs >= IDLE_TIMEOUT_MS) {
+        _fail("Upload timed out");
+    } else if (_state == OtaState::SUCCESS && millis() - _finishedMs >= REBOOT_DELAY_MS) {
+        ESP.restart();
+    }
+}
+
+uint8_t OtaUpdater::getProgress() const {
+    if (_state == OtaState::SUCCESS) {
+        return 100;
+    }
+    if (!_size) {
+        return 0;
+    }
+    return static_cast<uint8_t>(static_cast<uint64_t>(_written) * 100 / _size);
+}
+
+const char* OtaUpdater::getStateString(OtaState state) {
+    switch (state) {
+        case OtaState::RECEIVING:
+            return "receiving";
+        case OtaState::SUCCESS:
+            return "success";
+        case OtaState::FAILED:
+            return "failed";
+        default:
+            return "idle";
+    }
+}
+
+void OtaUpdater::_setState(OtaState state) {
+    _state = state;
+    if (_callback) {
+        _callback(state);
+    }
+}
+
+void OtaUpdater::_fail(const char* reason) {
+    if (isActive()) {
+        Update.end(false);
+    }
+    if (_cpu) {
+        _cpu->setDemand(CpuGovernor::DEMAND_OTA, false);
+    }
+    _error = reason;
+    Log.print("OTA failed: ");
+    Log.println(reason);
+    _setState(OtaState::FAILED);
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "CpuGovernor.h"
+
+namespace lovi {
+
+enum class OtaState : uint8_t {
+    IDLE,
+    RECEIVING,
+    SUCCESS,
+    FAILED
+};
+
+// Streams a firmware image into the spare flash partition as it arrives.
+// The updater stages writes in one flash sector, so memory use does not
+// depend on the image size. A successful image reboots the device
+// shortly after end() so the HTTP response can still go out.
+class OtaUpdater {
+public:
+    typedef std::function<void(OtaState)> StateCallback;
+
+    static const uint32_t IDLE_TIMEOUT_MS = 10000;
+    static const uint32_t REBOOT_DELAY_MS = 500;
+
+    explicit OtaUpdater(CpuGovernor* cpu = nullptr);
+
+    // md5 is the hex digest of the full image; size may be 0 when unknown.
+    bool begin(uint32_t size, const char* md5);
+    bool write(const uint8_t* data, size_t length);
+    bool end();
+    void abort(const char* reason);
+
+    // Handles stalled uploads and the deferred reboot.
+    void update();
+
+    OtaState getState() const { return _state; }
+    bool isActive() const { return _state == OtaState::RECEIVING; }
+    uint32_t getWritten() const { return _written; }
+    uint32_t getSize() const { return _size; }
+    uint8_t getProgress() const;
+    const char* getError() const { return _error; }
+    static const char* getStateString(OtaState state);
+
+    void onStateChange(StateCallback callback) { _callback = callback; }
+
+private:
+    CpuGovernor* _cpu;
+    OtaState _state;
+    uint32_t _size;
+    uint32_t _written;
+    uint32_t _lastWriteMs;
+    uint32_t _finishedMs;
+    uint8_t _reportedDecile;
+    const char* _error;
+    StateCallback _callback;
+
+    void _setState(OtaState state);
+    void _fail(const char* reason);
+};
+
+}
@@ -0,0 +1,123 @@
+#include "PowerManager.h"
+#include "Log.h"
+#include <ESP8266WiFi.h>
+
+extern "C" {
+#include <user_interface.h>
+}
+
+namespace lovi {
+
+PowerManager::PowerManager(Scheduler* scheduler, Metrics* metrics)
+    : _scheduler(scheduler)
+    , _metrics(metrics)
+    , _mode(PowerMode::PERFORMANCE)
+    , _wakePinCount(0)
+    , _throttledCount(0) {
+    if (_metrics) {
+        _metrics->setPowerMode(getModeString(_mode));
+    }
+}
+
+bool PowerManager::addWakePin(uint8_t pin) {
+    if (_wakePinCount >= MAX_WAKE_PINS) {
+        return false;
+    }
+    _wakePins[_wakePinCount].pin = pin;
+    _wakePins[_wakePinCount].interruptType = GPIO_PIN_INTR_DISABLE;
+    _wakePinCount++;
+    return true;
+}
+
+bool PowerManager::throttleTask(int8_t id, uint32_t sleepPeriodMs) {
+    if (id < 0 || _throttledCount >= MAX_THROTTLED_TASKS) {
+        return false;
+    }
+
+    ThrottledTask& task = _throttled[_throttledCount++];
+    task.id = id;
+    task.activePeriodMs = _scheduler->getPeriod(id);
+    task.sleepPeriodMs = sleepPeriodMs;
+    if (_mode != PowerMode::PERFORMANCE) {
+        _scheduler->setPeriod(id, sleepPeriodMs);
+    }
+    return true;
+}
+
+void PowerManager::setMode(PowerMode mode) {
+    wifi_disable_gpio_wakeup();
+    _scheduler->onSleep(nullptr);
+
+    switch (mode) {
+        case PowerMode::MODEM_SLEEP:
+            WiFi.setSleepMode(WIFI_MODEM_SLEEP);
+            break;
+        case PowerMode::LIGHT_SLEEP:
+            if (_wakePinCount > 0) {
+                _scheduler->onSleep([this](bool asleep) {
+                    if (asleep) {
+                        _armWakePins();
+                    } else {
+                        _disarmWakePins();
+                    }
+                });
+            }
+            WiFi.setSleepMode(WIFI_LIGHT_SLEEP, LIGHT_SLEEP_LISTEN_INTERVAL);
+            break;
+        default:
+            WiFi.setSleepMode(WIFI_NONE_SLEEP);
+            break;
+    }
+
+    // The SDK only enters light sleep during long enough idle stretches.
+    uint32_t maxSleepMs = Scheduler::DEFAULT_MAX_SLEEP_MS;
+    if (mode == PowerMode::LIGHT_SLEEP) {
+        maxSleepMs = LIGHT_SLEEP_MAX_SLEEP_MS;
+    }
+    _scheduler->setMaxSleep(maxSleepMs);
+
+    bool sleeping = mode != PowerMode::PERFORMANCE;
+    for (uint8_t i = 0; i < _throttledCount; i++) {
+        const ThrottledTask& task = _throttled[i];
+        _scheduler->setPeriod(task.id, sleeping ? task.sleepPeriodMs : task.activePeriodMs);
+    }
+
+    _mode = mode;
+    if (_metrics) {
+        _metrics->setPowerMode(getModeString(mode));
+    }
+
+    Log.print("Power mode: ");
+    Log.println(getModeString(mode));
+}
+
+void PowerManager::_armWakePins() {
+    for (uint8_t i = 0; i < _wakePinCount; i++) {
+        WakePin& wake = _wakePins[i];
+        wake.interruptType = (GPC(wake.pin) >> GPCI) & 7;
+        // Waking on the current level would re-fire until the wait is over.
+        GPIO_INT_TYPE level = digitalRead(wake.pin) ? GPIO_PIN_INTR_LOLEVEL : GPIO_PIN_INTR_HILEVEL;
+        wifi_enable_gpio_wakeup(wake.pin, level);
+    }
+}
+
+void PowerManager::_disarmWakePins() {
+    wifi_disable_gpio_wakeup();
+    for (uint8_t i = 0; i < _wakePinCount; i++) {
+        const WakePin& wake = _wakePins[i];
+        GPC(wake.pin) = (GPC(wake.pin) & ~(7 << GPCI)) | (wake.interruptType << GPCI);
+    }
+}
+
+const char* PowerManager::getModeString(PowerMode mode) {
+    switch (mode) {
+        case PowerMode::MODEM_SLEEP:
+            return "modem_sleep";
+        case PowerMode::LIGHT_SLEEP:
+            return "light_sleep";
+        default:
+            return "performance";
+    }
+}
+
+}
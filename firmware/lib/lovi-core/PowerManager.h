@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Arduino.h>
+#include "Scheduler.h"
+#include "Metrics.h"
+
+namespace lovi {
+
+enum class PowerMode : uint8_t {
+    PERFORMANCE,  // Modem and CPU always awake
+    MODEM_SLEEP,  // Modem sleeps between DTIM beacons, CPU stays awake
+    LIGHT_SLEEP   // CPU is also suspended while the scheduler idles
+};
+
+// Trades response latency for current draw. Light sleep wakes on the listen
+// interval and on wake pins; UART bytes arriving while the CPU is suspended
+// are lost, so it suits installs that rely on the radar's GPIO outputs.
+//
+// The SDK only wakes on a level trigger, which replaces the pin's own
+// interrupt type (InputCapture's CHANGE). Wake pins are therefore armed only
+// for each idle wait, at the level opposite to the pin's current state, and
+// the pin's interrupt type is restored as soon as the wait is over. A wake
+// that fires mid-wait reaches the pin's handler, which must put back its
+// own trigger (InputCapture does) or the level keeps firing until then.
+class PowerManager {
+public:
+    static const uint8_t MAX_WAKE_PINS = 2;
+    static const uint8_t MAX_THROTTLED_TASKS = 4;
+    static const uint8_t LIGHT_SLEEP_LISTEN_INTERVAL = 3;
+    static const uint32_t LIGHT_SLEEP_MAX_SLEEP_MS = 100;
+
+    PowerManager(Scheduler* scheduler, Metrics* metrics = nullptr);
+
+    // Either edge on the pin ends light sleep.
+    bool addWakePin(uint8_t pin);
+    // Runs the task at sleepPeriodMs instead of its own period in either sleep mode.
+    bool throttleTask(int8_t id, uint32_t sleepPeriodMs);
+
+    void setMode(PowerMode mode);
+    PowerMode getMode() const { return _mode; }
+    static const char* getModeString(PowerMode mode);
+
+private:
+    struct WakePin {
+        uint8_t pin;
+        uint8_t interruptType;
+    };
+
+    struct ThrottledTask {
+        int8_t id;
+        uint32_t activePeriodMs;
+        uint32_t sleepPeriodMs;
+    };
+
+    Scheduler* _scheduler;
+    Metrics* _metrics;
+    PowerMode _mode;
+    WakePin _wakePins[MAX_WAKE_PINS];
+    uint8_t _wakePinCount;
+    ThrottledTask _throttled[MAX_THROTTLED_TASKS];
+    uint8_t _throttledCount;
+
+    void _armWakePins();
+    void _disarmWakePins();
+};
+
+}
@@ -0,0 +1,168 @@
+#include "RadarParser.h"
+
+namespace lovi {
+
+static const uint8_t FRAME_HEADER[4] = {0xF4, 0xF3, 0xF2, 0xF1};
+static const uint8_t FRAME_FOOTER[4] = {0xF8, 0xF7, 0xF6, 0xF5};
+static const uint8_t TYPE_ENGINEERING = 0x01;
+static const uint8_t TYPE_BASIC = 0x02;
+static const uint8_t TARGET_HEAD = 0xAA;
+static const uint8_t TARGET_TAIL = 0x55;
+static const uint8_t TARGET_CHECK = 0x00;
+
+// Offsets of the basic target fields inside the payload.
+static const uint16_t BASIC_LENGTH = 13;
+static const uint16_t ENGINEERING_GATES_OFFSET = 11;
+
+RadarParser::RadarParser()
+    : _stream(nullptr)
+    , _state(State::HEADER)
+    , _matched(0)
+    , _length(0)
+    , _offset(0)
+    , _reportTimeMs(0)
+    , _frames(0)
+    , _corrupt(0)
+    , _droppedBytes(0) {
+}
+
+void RadarParser::begin(Stream* stream) {
+    _stream = stream;
+    _resync(false);
+}
+
+bool RadarParser::poll() {
+    if (!_stream) {
+        return false;
+    }
+
+    bool completed = false;
+    for (size_t i = 0; i < MAX_BYTES_PER_POLL && _stream->available() > 0; i++) {
+        completed |= feed(_stream->read());
+    }
+    return completed;
+}
+
+bool RadarParser::feed(uint8_t byte) {
+    switch (_state) {
+        case State::HEADER:
+            if (byte == FRAME_HEADER[_matched]) {
+                if (++_matched == sizeof(FRAME_HEADER)) {
+                    _state = State::LENGTH;
+                    _matched = 0;
+                    _length = 0;
+                }
+            } else {
+                _droppedBytes += _matched + 1;
+                // A failed match may itself start the next header.
+                _matched = byte == FRAME_HEADER[0] ? 1 : 0;
+                _droppedBytes -= _matched;
+            }
+            return false;
+
+        case State::LENGTH:
+            _length |= static_cast<uint16_t>(byte) << (8 * _matched);
+            if (++_matched == 2) {
+                if (_length < BASIC_LENGTH || _length > MAX_PAYLOAD_LENGTH) {
+                    _resync(true);
+                    return false;
+                }
+                _state = State::PAYLOAD;
+                _matched = 0;
+                _offset = 0;
+                _pending = RadarReport();
+            }
+            return false;
+
+        case State::PAYLOAD:
+            if (!_decodePayload(byte)) {
+                _resync(true);
+                return false;
+            }
+            if (++_offset == _length) {
+                _state = State::FOOTER;
+            }
+            return false;
+
+        case State::FOOTER:
+            if (byte != FRAME_FOOTER[_matched]) {
+                _resync(true);
+                return false;
+            }
+            if (++_matched < sizeof(FRAME_FOOTER)) {
+                return false;
+            }
+            _report = _pending;
+            _reportTimeMs = millis();
+            _frames++;
+            _resync(false);
+            return true;
+    }
+    return false;
+}
+
+bool RadarParser::_decodePayload(uint8_t byte) {
+    RadarReport& r = _pending;
+
+    // The last two payload bytes are always the tail and check byte.
+    if (_offset == _length - 2) {
+        return byte == TARGET_TAIL;
+    }
+    if (_offset == _length - 1) {
+        return byte == TARGET_CHECK;
+    }
+
+    switch (_offset) {
+        case 0:
+            r.engineering = byte == TYPE_ENGINEERING;
+            return byte == TYPE_ENGINEERING || byte == TYPE_BASIC;
+        case 1:
+            return byte == TARGET_HEAD;
+        case 2:
+            r.state = static_cast<RadarTargetState>(byte & 0x03);
+            return byte <= 0x03;
+        case 3: r.movingDistanceCm = byte; return true;
+        case 4: r.movingDistanceCm |= byte << 8; return true;
+        case 5: r.movingEnergy = byte; return true;
+        case 6: r.staticDistanceCm = byte; return true;
+        case 7: r.staticDistanceCm |= byte << 8; return true;
+        case 8: r.staticEnergy = byte; return true;
+        case 9: r.detectionDistanceCm = byte; return true;
+        case 10: r.detectionDistanceCm |= byte << 8; return true;
+        default:
+            break;
+    }
+
+    if (!r.engineering) {
+        // Basic frames carry nothing between the target data and the tail.
+        return false;
+    }
+
+    // Engineering data: max moving gate, max static gate, then one energy
+    // byte per gate for moving and static targets, then vendor extras.
+    uint16_t index = _offset - ENGINEERING_GATES_OFFSET;
+    if (index == 0) {
+        r.gateCount = (byte < RadarReport::MAX_GATES ? byte : RadarReport::MAX_GATES - 1) + 1;
+        return true;
+    }
+    if (index == 1) {
+        return true;
+    }
+    index -= 2;
+    if (index < r.gateCount) {
+        r.movingGateEnergy[index] = byte;
+    } else if (index < 2 * r.gateCount) {
+        r.staticGateEnergy[index - r.gateCount] = byte;
+    }
+    return true;
+}
+
+void RadarParser::_resync(bool corrupt) {
+    if (corrupt) {
+        _corrupt++;
+    }
+    _state = State::HEADER;
+    _matched = 0;
+}
+
+}
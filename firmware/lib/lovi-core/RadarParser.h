@@ -0,0 +1,84 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace lovi {
+
+enum class RadarTargetState : uint8_t {
+    NONE = 0,
+    MOVING = 1,
+    STATIC = 2,
+    MOVING_AND_STATIC = 3
+};
+
+struct RadarReport {
+    static const uint8_t MAX_GATES = 9;
+
+    RadarTargetState state = RadarTargetState::NONE;
+    uint16_t movingDistanceCm = 0;
+    uint8_t movingEnergy = 0;
+    uint16_t staticDistanceCm = 0;
+    uint8_t staticEnergy = 0;
+    uint16_t detectionDistanceCm = 0;
+
+    // Only filled by engineering-mode frames.
+    bool engineering = false;
+    uint8_t gateCount = 0;
+    uint8_t movingGateEnergy[MAX_GATES] = {0};
+    uint8_t staticGateEnergy[MAX_GATES] = {0};
+};
+
+// Incremental parser for LD2410-family report frames:
+//   F4 F3 F2 F1 | len (u16 LE) | type, 0xAA, target data, [gates], 0x55, 0x00 | F8 F7 F6 F5
+// Bytes are decoded straight into the pending report as they arrive; the
+// report is only published once the tail, check byte and footer match.
+class RadarParser {
+public:
+    static const uint32_t BAUD_RATE = 256000;
+    static const size_t RX_BUFFER_SIZE = 512;
+    static const size_t MAX_BYTES_PER_POLL = 256;
+    static const uint16_t MAX_PAYLOAD_LENGTH = 64;
+
+    RadarParser();
+
+    void begin(Stream* stream);
+
+    // Consumes up to MAX_BYTES_PER_POLL buffered bytes; true if a new
+    // report was completed.
+    bool poll();
+    bool feed(uint8_t byte);
+    int available() const { return _stream ? _stream->available() : 0; }
+
+    const RadarReport& getReport() const { return _report; }
+    uint32_t getReportTimeMs() const { return _reportTimeMs; }
+
+    uint32_t getFrameCount() const { return _frames; }
+    uint32_t getCorruptCount() const { return _corrupt; }
+    uint32_t getDroppedBytes() const { return _droppedBytes; }
+
+private:
+    enum class State : uint8_t {
+        HEADER,
+        LENGTH,
+        PAYLOAD,
+        FOOTER
+    };
+
+    Stream* _stream;
+    State _state;
+    uint8_t _matched;
+    uint16_t _length;
+    uint16_t _offset;
+    RadarReport _pending;
+    RadarReport _report;
+    uint32_t _reportTimeMs;
+
+    uint32_t _frames;
+    uint32_t _corrupt;
+    uint32_t _droppedBytes;
+
+    bool _decodePayload(uint8_t byte);
+    void _resync(bool corrupt);
+};
+
+}
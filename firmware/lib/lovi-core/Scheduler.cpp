@@ -0,0 +1,154 @@
+#include "Scheduler.h"
+
+namespace lovi {
+
+Scheduler::Scheduler(Metrics* metrics)
+    : _metrics(metrics)
+    , _taskCount(0)
+    , _maxSleepUs(DEFAULT_MAX_SLEEP_MS * 1000)
+    , _windowStartUs(micros())
+    , _windowBusyUs(0)
+    , _dutyPermille(1000) {
+}
+
+int8_t Scheduler::addTask(const char* name, uint32_t periodMs, TaskCallback callback, uint32_t deadlineMs) {
+    if (_taskCount >= MAX_TASKS) {
+        return -1;
+    }
+
+    Task& task = _tasks[_taskCount];
+    task.name = name;
+    task.callback = callback;
+    task.periodUs = periodMs * 1000;
+    task.deadlineUs = deadlineMs * 1000;
+    task.nextRunUs = micros();
+    task.enabled = true;
+    task.probe = _metrics ? _metrics->addProbe(name) : -1;
+    task.stats = TaskStats();
+    return _taskCount++;
+}
+
+void Scheduler::setPeriod(int8_t id, uint32_t periodMs) {
+    if (_isValid(id)) {
+        _tasks[id].periodUs = periodMs * 1000;
+    }
+}
+
+void Scheduler::setEnabled(int8_t id, bool enabled) {
+    if (!_isValid(id)) {
+        return;
+    }
+    if (enabled && !_tasks[id].enabled) {
+        _tasks[id].nextRunUs = micros();
+    }
+    _tasks[id].enabled = enabled;
+}
+
+uint32_t Scheduler::getPeriod(int8_t id) const {
+    return _isValid(id) ? _tasks[id].periodUs / 1000 : 0;
+}
+
+const char* Scheduler::getTaskName(int8_t id) const {
+    return _isValid(id) ? _tasks[id].name : nullptr;
+}
+
+const Scheduler::TaskStats* Scheduler::getTaskStats(int8_t id) const {
+    return _isValid(id) ? &_tasks[id].stats : nullptr;
+}
+
+void Scheduler::run() {
+    uint32_t start = micros();
+    uint32_t now = start;
+    uint8_t ran = 0;
+    int8_t id;
+
+    // Oldest due task first, so a slow task cannot starve the others.
+    while ((id = _nextDue(now, ran)) >= 0) {
+        Task& task = _tasks[id];
+        ran |= 1 << id;
+        uint32_t lateness = now - task.nextRunUs;
+        if (lateness > task.stats.maxLatenessUs) {
+            task.stats.maxLatenessUs = lateness;
+        }
+        if (task.deadlineUs && lateness > task.deadlineUs) {
+            task.stats.missedDeadlines++;
+        }
+
+        uint32_t taskStart = ESP.getCycleCount();
+        task.callback();
+        if (_metrics) {
+            _metrics->record(task.probe, ESP.getCycleCount() - taskStart);
+        }
+        task.stats.runs++;
+
+        // Keep the original phase, but never burst to catch up on missed periods.
+        task.nextRunUs += task.periodUs;
+        now = micros();
+        if (static_cast<int32_t>(now - task.nextRunUs) >= 0) {
+            task.nextRunUs = now + task.periodUs;
+        }
+    }
+
+    now = micros();
+    _windowBusyUs += now - start;
+
+    uint32_t waitUs = _timeUntilNextUs(now);
+    if (waitUs >= 1000) {
+        if (_sleepCallback) {
+            _sleepCallback(true);
+        }
+        delay(waitUs / 1000);
+        if (_sleepCallback) {
+            _sleepCallback(false);
+        }
+    } else {
+        yield();
+    }
+
+    uint32_t window = micros() - _windowStartUs;
+    if (window >= DUTY_WINDOW_US) {
+        _dutyPermille = static_cast<uint16_t>(static_cast<uint64_t>(_windowBusyUs) * 1000 / window);
+        if (_metrics) {
+            _metrics->recordDutyCycle(_windowBusyUs, window);
+        }
+        _windowStartUs += window;
+        _windowBusyUs = 0;
+    }
+}
+
+int8_t Scheduler::_nextDue(uint32_t now, uint8_t skip) const {
+    int8_t best = -1;
+    int32_t bestOverdue = -1;
+    for (uint8_t i = 0; i < _taskCount; i++) {
+        const Task& task = _tasks[i];
+        if (skip & (1 << i)) {
+            continue;
+        }
+        int32_t overdue = static_cast<int32_t>(now - task.nextRunUs);
+        if (task.enabled && overdue >= 0 && overdue > bestOverdue) {
+            best = i;
+            bestOverdue = overdue;
+        }
+    }
+    return best;
+}
+
+uint32_t Scheduler::_timeUntilNextUs(uint32_t now) const {
+    uint32_t wait = _maxSleepUs;
+    for (uint8_t i = 0; i < _taskCount; i++) {
+        const Task& task = _tasks[i];
+        if (!task.enabled) {
+            continue;
+        }
+        int32_t remaining = static_cast<int32_t>(task.nextRunUs - now);
+        if (remaining <= 0) {
+            return 0;
+        }
+        if (static_cast<uint32_t>(remaining) < wait) {
+            wait = remaining;
+        }
+    }
+    return wait;
+}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+#include "Metrics.h"
+
+namespace lovi {
+
+class Scheduler {
+public:
+    typedef std::function<void()> TaskCallback;
+    typedef std::function<void(bool asleep)> SleepCallback;
+
+    static const uint8_t MAX_TASKS = 8;
+    static const uint32_t DEFAULT_MAX_SLEEP_MS = 10;
+    static const uint32_t DUTY_WINDOW_US = 1000000;
+
+    struct TaskStats {
+        uint32_t runs;
+        uint32_t missedDeadlines;
+        uint32_t maxLatenessUs;
+    };
+
+    // When metrics are given, each task's run time is recorded as a probe.
+    Scheduler(Metrics* metrics = nullptr);
+
+    // Returns the task id, or -1 when the table is full. A deadline of 0
+    // means the task may start any time after it becomes due.
+    int8_t addTask(const char* name, uint32_t periodMs, TaskCallback callback, uint32_t deadlineMs = 0);
+    void setPeriod(int8_t id, uint32_t periodMs);
+    uint32_t getPeriod(int8_t id) const;
+    void setEnabled(int8_t id, bool enabled);
+
+    // Longest single idle wait; longer waits let the SDK sleep deeper.
+    void setMaxSleep(uint32_t ms) { _maxSleepUs = ms * 1000; }
+    // Called with true before each idle wait long enough to sleep, and with
+    // false once it is over.
+    void onSleep(SleepCallback callback) { _sleepCallback = callback; }
+
+    // Runs every due task once, then sleeps until the next one is due.
+    void run();
+
+    // Share of wall time spent running tasks over the last window.
+    uint16_t getDutyCyclePermille() const { return _dutyPermille; }
+
+    uint8_t getTaskCount() const { return _taskCount; }
+    const char* getTaskName(int8_t id) const;
+    const TaskStats* getTaskStats(int8_t id) const;
+
+private:
+    struct Task {
+        const char* name;
+        TaskCallback callback;
+        uint32_t periodUs;
+        uint32_t deadlineUs;
+        uint32_t nextRunUs;
+        bool enabled;
+        int8_t probe;
+        TaskStats stats;
+    };
+
+    Metrics* _metrics;
+    Task _tasks[MAX_TASKS];
+    uint8_t _taskCount;
+    uint32_t _maxSleepUs;
+    SleepCallback _sleepCallback;
+    uint32_t _windowStartUs;
+    uint32_t _windowBusyUs;
+    uint16_t _dutyPermille;
+
+    bool _isValid(int8_t id) const { return id >= 0 && id < _taskCount; }
+    int8_t _nextDue(uint32_t now, uint8_t skip) const;
+    uint32_t _timeUntilNextUs(uint32_t now) const;
+};
+
+}
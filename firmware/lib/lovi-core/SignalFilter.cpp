@@ -0,0 +1,93 @@
+#include "SignalFilter.h"
+
+namespace lovi {
+
+EmaFilter::EmaFilter(uint8_t shift)
+    : _shift(shift)
+    , _primed(false)
+    , _state(0) {
+}
+
+uint16_t EmaFilter::update(uint16_t value) {
+    int32_t sample = static_cast<int32_t>(value) << 8;
+    if (!_primed) {
+        _state = sample;
+        _primed = true;
+    } else {
+        _state += (sample - _state) >> _shift;
+    }
+    return static_cast<uint16_t>((_state + 0x80) >> 8);
+}
+
+HysteresisFilter::HysteresisFilter(uint16_t band)
+    : _band(band)
+    , _primed(false)
+    , _output(0) {
+}
+
+uint16_t HysteresisFilter::update(uint16_t value) {
+    if (!_primed) {
+        _output = value;
+        _primed = true;
+    } else if (value > _output + _band) {
+        _output = value - _band;
+    } else if (value + _band < _output) {
+        _output = value + _band;
+    }
+    return _output;
+}
+
+HoldDebounce::HoldDebounce(uint16_t assertMs, uint16_t releaseMs)
+    : _assertMs(assertMs)
+    , _releaseMs(releaseMs)
+    , _state(false)
+    , _pending(false)
+    , _pendingSinceMs(0) {
+}
+
+bool HoldDebounce::update(bool value, uint32_t nowMs) {
+    if (value == _state) {
+        _pending = false;
+        return _state;
+    }
+
+    if (!_pending) {
+        _pending = true;
+        _pendingSinceMs = nowMs;
+    }
+    uint16_t hold = value ? _assertMs : _releaseMs;
+    if (nowMs - _pendingSinceMs >= hold) {
+        _state = value;
+        _pending = false;
+    }
+    return _state;
+}
+
+void HoldDebounce::setHoldTimes(uint16_t assertMs, uint16_t releaseMs) {
+    _assertMs = assertMs;
+    _releaseMs = releaseMs;
+}
+
+SensorFilter::SensorFilter() {
+    configure(FilterConfig());
+}
+
+void SensorFilter::configure(const FilterConfig& config) {
+    _config = config;
+    _ema.setShift(config.emaShift);
+    _hysteresis.setBand(config.hysteresisCm);
+    _presence.setHoldTimes(config.presenceAssertMs, config.presenceReleaseMs);
+    _motion.setHoldTimes(config.motionAssertMs, config.motionReleaseMs);
+}
+
+uint16_t SensorFilter::distanceCm(uint16_t rawCm) {
+    if (rawCm == 0) {
+        _median.reset();
+        _ema.reset();
+        _hysteresis.reset();
+        return 0;
+    }
+    return _hysteresis.update(_ema.update(_median.update(rawCm)));
+}
+
+}
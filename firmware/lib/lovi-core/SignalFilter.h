@@ -0,0 +1,131 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace lovi {
+
+// Integer-only building blocks for conditioning raw sensor readings before
+// they reach Device::_setSensorData. None of them allocate.
+
+template <size_t N>
+class MedianFilter {
+public:
+    static_assert(N >= 1 && (N & 1) == 1, "MedianFilter window must be odd");
+
+    MedianFilter() : _count(0), _next(0) {}
+
+    uint16_t update(uint16_t value) {
+        _window[_next] = value;
+        _next = (_next + 1) % N;
+        if (_count < N) {
+            _count++;
+        }
+
+        uint16_t sorted[N];
+        for (size_t i = 0; i < _count; i++) {
+            uint16_t v = _window[i];
+            size_t j = i;
+            while (j > 0 && sorted[j - 1] > v) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = v;
+        }
+        return sorted[_count / 2];
+    }
+
+    void reset() {
+        _count = 0;
+        _next = 0;
+    }
+
+private:
+    uint16_t _window[N];
+    size_t _count;
+    size_t _next;
+};
+
+// Exponential moving average with alpha = 1 / 2^shift, kept in Q8.
+class EmaFilter {
+public:
+    explicit EmaFilter(uint8_t shift = 2);
+
+    uint16_t update(uint16_t value);
+    void reset() { _primed = false; }
+    void setShift(uint8_t shift) { _shift = shift; }
+
+private:
+    uint8_t _shift;
+    bool _primed;
+    int32_t _state;
+};
+
+// Output follows the input only once it has moved more than `band` away,
+// then trails it by `band`, so jitter inside the band never shows up.
+class HysteresisFilter {
+public:
+    explicit HysteresisFilter(uint16_t band = 0);
+
+    uint16_t update(uint16_t value);
+    void reset() { _primed = false; }
+    void setBand(uint16_t band) { _band = band; }
+
+private:
+    uint16_t _band;
+    bool _primed;
+    uint16_t _output;
+};
+
+// Boolean debounce: the output only changes once the input has held its
+// new level for assertMs (rising) or releaseMs (falling).
+class HoldDebounce {
+public:
+    HoldDebounce(uint16_t assertMs = 0, uint16_t releaseMs = 0);
+
+    bool update(bool value, uint32_t nowMs);
+    bool getState() const { return _state; }
+    void setHoldTimes(uint16_t assertMs, uint16_t releaseMs);
+
+private:
+    uint16_t _assertMs;
+    uint16_t _releaseMs;
+    bool _state;
+    bool _pending;
+    uint32_t _pendingSinceMs;
+};
+
+struct FilterConfig {
+    uint8_t emaShift = 2;
+    uint16_t hysteresisCm = 4;
+    uint16_t presenceAssertMs = 0;
+    uint16_t presenceReleaseMs = 1000;
+    uint16_t motionAssertMs = 0;
+    uint16_t motionReleaseMs = 500;
+};
+
+// Median-of-5 -> EMA -> hysteresis for distance, hold-time debounce for
+// presence and motion. A raw distance of 0 means "no target" and resets
+// the distance chain so stale readings don't bleed into the next target.
+class SensorFilter {
+public:
+    static const size_t MEDIAN_WINDOW = 5;
+
+    SensorFilter();
+
+    void configure(const FilterConfig& config);
+    const FilterConfig& getConfig() const { return _config; }
+
+    uint16_t distanceCm(uint16_t rawCm);
+    bool presence(bool raw, uint32_t nowMs) { return _presence.update(raw, nowMs); }
+    bool motion(bool raw, uint32_t nowMs) { return _motion.update(raw, nowMs); }
+
+private:
+    FilterConfig _config;
+    MedianFilter<MEDIAN_WINDOW> _median;
+    EmaFilter _ema;
+    HysteresisFilter _hysteresis;
+    HoldDebounce _presence;
+    HoldDebounce _motion;
+};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+namespace lovi {
+
+// Single-producer/single-consumer ring safe between one ISR and the main
+// loop on a single core. Capacity must be a power of two; one slot stays
+// free to tell full from empty. push() is forced inline so that, when
+// called from an IRAM ISR, no flash-resident code runs.
+template <typename T, size_t N>
+class SpscQueue {
+public:
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+    SpscQueue() : _head(0), _tail(0) {}
+
+    inline __attribute__((always_inline)) bool push(const T& item) {
+        size_t head = _head;
+        size_t next = (head + 1) & (N - 1);
+        if (next == _tail) {
+            return false;
+        }
+        _items[head] = item;
+        __asm__ __volatile__("" ::: "memory");
+        _head = next;
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t tail = _tail;
+        if (tail == _head) {
+            return false;
+        }
+        item = _items[tail];
+        __asm__ __volatile__("" ::: "memory");
+        _tail = (tail + 1) & (N - 1);
+        return true;
+    }
+
+    bool isEmpty() const { return _head == _tail; }
+    size_t size() const { return (_head - _tail) & (N - 1); }
+
+private:
+    T _items[N];
+    volatile size_t _head;
+    volatile size_t _tail;
+};
+
+}
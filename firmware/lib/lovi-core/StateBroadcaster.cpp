@@ -0,0 +1,74 @@
+#include "StateBroadcaster.h"
+#include "Device.h"
+
+namespace lovi {
+
+static const IPAddress BROADCAST_GROUP(239, 255, 76, 86);
+
+StateBroadcaster::StateBroadcaster(Device* device, const DeviceIdentity& identity)
+    : _device(device)
+    , _identity(identity)
+    , _running(false)
+    , _lastSequence(0)
+    , _lastSendMs(0)
+    , _sent(0) {
+}
+
+void StateBroadcaster::begin() {
+    if (_running) {
+        return;
+    }
+    _running = true;
+    // Announce immediately so listeners learn about the device on join.
+    _lastSequence = _device->getSensorSequence() - 1;
+    _lastSendMs = millis() - HEARTBEAT_MS;
+}
+
+void StateBroadcaster::update() {
+    if (!_running || !_device->getSettings().broadcast) {
+        return;
+    }
+
+    uint32_t now = millis();
+    uint32_t sequence = _device->getSensorSequence();
+    if (sequence != _lastSequence) {
+        if (now - _lastSendMs >= MIN_INTERVAL_MS) {
+            _send(_device->getChangedFields());
+        }
+    } else if (now - _lastSendMs >= HEARTBEAT_MS) {
+        _send(0);
+    }
+}
+
+void StateBroadcaster::stop() {
+    if (_running) {
+        _udp.stop();
+        _running = false;
+    }
+}
+
+void StateBroadcaster::_send(uint8_t changed) {
+    uint8_t packet[BROADCAST_PACKET_SIZE];
+    packet[0] = 'L';
+    packet[1] = 'O';
+    packet[2] = 'V';
+    packet[3] = 'I';
+    packet[4] = BROADCAST_VERSION;
+    packet[5] = 0;
+    memcpy(packet + 6, _identity.mac, sizeof(_identity.mac));
+
+    uint32_t sequence = _device->getSensorSequence();
+    size_t length = BROADCAST_HEADER_SIZE + encodeTelemetry(
+        _device->getSensorData(), sequence, changed,
+        packet + BROADCAST_HEADER_SIZE, sizeof(packet) - BROADCAST_HEADER_SIZE);
+
+    if (_udp.beginPacketMulticast(BROADCAST_GROUP, PORT, WiFi.localIP())) {
+        _udp.write(packet, length);
+        _udp.endPacket();
+        _sent++;
+    }
+    _lastSequence = sequence;
+    _lastSendMs = millis();
+}
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "Telemetry.h"
+#include "types.h"
+
+namespace lovi {
+
+class Device;
+
+// Datagram: "LOVI", u8 version, u8 reserved, u8[6] MAC, telemetry frame.
+static const uint8_t BROADCAST_VERSION = 1;
+static const size_t BROADCAST_HEADER_SIZE = 12;
+static const size_t BROADCAST_PACKET_SIZE = BROADCAST_HEADER_SIZE + TELEMETRY_FRAME_SIZE;
+
+// Multicasts the sensor state on every change and as a heartbeat, so a
+// listener can follow a whole fleet without one TCP poll per device.
+class StateBroadcaster {
+public:
+    static const uint16_t PORT = 47476;
+    static const uint32_t HEARTBEAT_MS = 25000;
+    static const uint32_t MIN_INTERVAL_MS = 50;
+
+    StateBroadcaster(Device* device, const DeviceIdentity& identity);
+
+    void begin();
+    void update();
+    void stop();
+
+    bool isRunning() const { return _running; }
+    uint32_t getSentCount() const { return _sent; }
+
+private:
+    Device* _device;
+    const DeviceIdentity& _identity;
+    WiFiUDP _udp;
+    bool _running;
+    uint32_t _lastSequence;
+    uint32_t _lastSendMs;
+    uint32_t _sent;
+
+    void _send(uint8_t changed);
+};
+
+}
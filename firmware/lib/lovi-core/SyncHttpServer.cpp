@@ -0,0 +1,186 @@
+#include "HttpServer.h"
+#include "Log.h"
+
+#if !LOVI_ASYNC_HTTP
+
+namespace lovi {
+
+void SyncHttpRequest::beginChunked(int code, const char* contentType) {
+    _web.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _web.send(code, contentType, "");
+}
+
+uintptr_t SyncHttpRequest::connectionId() const {
+    return _server._uploading ? _server._uploadId : 0;
+}
+
+bool SyncHttpRequest::openEventStream() {
+    return _server._acceptEventStream();
+}
+
+#if LOVI_TLS
+SyncHttpServer::SyncHttpServer(uint16_t port)
+    : _web(port)
+    , _uploadId(0)
+    , _uploading(false)
+    , _sessions(_sessionStore, TLS_SESSION_CACHE_SIZE) {
+    _web.getServer().setCache(&_sessions);
+}
+
+bool SyncHttpServer::setCertificate(const char* certPem, const char* keyPem) {
+    if (!_certificate.append(certPem) || !_key.parse(keyPem)) {
+        Log.println("Invalid TLS certificate or key");
+        return false;
+    }
+    if (_key.isRSA()) {
+        _web.getServer().setRSACert(&_certificate, &_key);
+    } else {
+        _web.getServer().setECCert(&_certificate, BR_KEYTYPE_EC, &_key);
+    }
+    return true;
+}
+#else
+SyncHttpServer::SyncHttpServer(uint16_t port)
+    : _web(port)
+    , _uploadId(0)
+    , _uploading(false) {
+}
+#endif
+
+void SyncHttpServer::collectHeaders(const char** keys, size_t count) {
+    _web.collectHeaders(keys, count);
+}
+
+void SyncHttpServer::on(const char* path, Handler handler) {
+    _web.on(path, [this, handler]() {
+        SyncHttpRequest request(*this, _web);
+        handler(request);
+    });
+}
+
+void SyncHttpServer::onUpload(const char* path, Handler handler, UploadHandler upload) {
+    _web.on(path, HTTP_POST, [this, handler]() {
+        SyncHttpRequest request(*this, _web);
+        handler(request);
+        _uploading = false;
+    }, [this, upload]() {
+        HTTPUpload& raw = _web.upload();
+        HttpUploadChunk chunk = { HttpUploadChunk::WRITE, raw.buf, raw.currentSize,
+                                  raw.totalSize };
+        switch (raw.status) {
+            case UPLOAD_FILE_START:
+                chunk.status = HttpUploadChunk::START;
+                chunk.length = 0;
+                // Never 0, so the id cannot match "no upload".
+                _uploadId = _uploadId + 1 ? _uploadId + 1 : 1;
+                _uploading = true;
+                break;
+            case UPLOAD_FILE_END:
+                chunk.status = HttpUploadChunk::END;
+                chunk.length = 0;
+                break;
+            case UPLOAD_FILE_ABORTED:
+                chunk.status = HttpUploadChunk::ABORTED;
+                chunk.length = 0;
+                break;
+            default:
+                // totalSize already includes this chunk.
+                chunk.offset = raw.totalSize - raw.currentSize;
+                break;
+        }
+        SyncHttpRequest request(*this, _web);
+        upload(request, chunk);
+        // An aborted upload never reaches the completion handler.
+        if (chunk.status == HttpUploadChunk::ABORTED) {
+            _uploading = false;
+        }
+    });
+}
+
+void SyncHttpServer::onNotFound(Handler handler) {
+    _web.onNotFound([this, handler]() {
+        SyncHttpRequest request(*this, _web);
+        handler(request);
+    });
+}
+
+void SyncHttpServer::begin(uint16_t port) {
+    // handleClient() serves one connection at a time; an idle keep-alive
+    // client would hold every other client off until it times out.
+    _web.keepAlive(false);
+    _web.begin(port);
+}
+
+void SyncHttpServer::update() {
+    _web.handleClient();
+}
+
+void SyncHttpServer::stop() {
+    for (uint8_t i = 0; i < MAX_EVENT_STREAMS; i++) {
+        _streams[i].stop();
+    }
+    _web.stop();
+}
+
+uint8_t SyncHttpServer::getEventStreamCount() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < MAX_EVENT_STREAMS; i++) {
+        if (_streams[i].connected()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void SyncHttpServer::sendEvent(const char* event, const char* data, uint32_t id) {
+    char frame[MAX_EVENT_SIZE];
+    int length = snprintf(frame, sizeof(frame), "id: %u\nevent: %s\ndata: %s\n\n",
+                          static_cast<unsigned>(id), event, data);
+    if (length < 0 || static_cast<size_t>(length) >= sizeof(frame)) {
+        Log.println("Event too large for stream frame");
+        return;
+    }
+    _writeEventStreams(frame, length);
+}
+
+void SyncHttpServer::sendComment(const char* comment) {
+    char frame[48];
+    int length = snprintf(frame, sizeof(frame), ": %s\n\n", comment);
+    if (length > 0 && static_cast<size_t>(length) < sizeof(frame)) {
+        _writeEventStreams(frame, length);
+    }
+}
+
+bool SyncHttpServer::_acceptEventStream() {
+    for (uint8_t i = 0; i < MAX_EVENT_STREAMS; i++) {
+        if (_streams[i].connected()) {
+            continue;
+        }
+        SyncWebClient client = _web.client();
+        client.setNoDelay(true);
+        client.print(F("HTTP/1.1 200 OK\r\n"
+                       "Content-Type: text/event-stream\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Connection: keep-alive\r\n"
+                       "\r\n"));
+        _streams[i] = client;
+        return true;
+    }
+    return false;
+}
+
+void SyncHttpServer::_writeEventStreams(const char* frame, size_t length) {
+    for (uint8_t i = 0; i < MAX_EVENT_STREAMS; i++) {
+        SyncWebClient& client = _streams[i];
+        if (!client.connected()) {
+            continue;
+        }
+        if (client.write(reinterpret_cast<const uint8_t*>(frame), length) != length) {
+            client.stop();
+        }
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+#include <functional>
+#include "HttpUpload.h"
+
+#if LOVI_TLS
+#include <ESP8266WebServerSecure.h>
+#endif
+
+namespace lovi {
+
+#if LOVI_TLS
+typedef BearSSL::ESP8266WebServerSecure SyncWebServer;
+typedef BearSSL::WiFiClientSecure SyncWebClient;
+#else
+typedef ESP8266WebServer SyncWebServer;
+typedef WiFiClient SyncWebClient;
+#endif
+
+class SyncHttpServer;
+
+class SyncHttpRequest {
+public:
+    SyncHttpRequest(SyncHttpServer& server, SyncWebServer& web)
+        : _server(server), _web(web) {}
+
+    bool isPost() { return _web.method() == HTTP_POST; }
+    String body() { return _web.arg("plain"); }
+    bool hasHeader(const char* name) { return _web.hasHeader(name); }
+    String header(const char* name) { return _web.header(name); }
+    bool hasArg(const char* name) { return _web.hasArg(name); }
+    String arg(const char* name) { return _web.arg(name); }
+    // One client is served at a time, so the upload in progress is the only
+    // connection worth telling apart; every other request reads as 0.
+    uintptr_t connectionId() const;
+
+    void sendHeader(const char* name, const char* value) { _web.sendHeader(name, value); }
+    void send(int code) { _web.send(code); }
+    void send(int code, const char* contentType, const char* body) { _web.send(code, contentType, body); }
+    void send(int code, const char* contentType, const char* body, size_t length) {
+        _web.send(code, contentType, body, length);
+    }
+    void send_P(int code, PGM_P contentType, PGM_P body, size_t length) {
+        _web.send_P(code, contentType, body, length);
+    }
+
+    void beginChunked(int code, const char* contentType);
+    void sendChunk(const char* data, size_t length) { _web.sendContent(data, length); }
+    void endChunked() { _web.sendContent(""); }
+
+    // Hands the connection over to the server's event stream slots.
+    bool openEventStream();
+
+private:
+    SyncHttpServer& _server;
+    SyncWebServer& _web;
+};
+
+class SyncHttpServer {
+public:
+    typedef std::function<void(SyncHttpRequest&)> Handler;
+    typedef std::function<void(SyncHttpRequest&, const HttpUploadChunk&)> UploadHandler;
+
+#if LOVI_TLS
+    // Every TLS connection holds its own BearSSL buffers, so streams are scarce.
+    static const uint8_t MAX_EVENT_STREAMS = 1;
+    static const uint8_t TLS_SESSION_CACHE_SIZE = 4;
+#else
+    static const uint8_t MAX_EVENT_STREAMS = 4;
+#endif
+    static const size_t MAX_EVENT_SIZE = 320;
+
+    explicit SyncHttpServer(uint16_t port);
+
+#if LOVI_TLS
+    // PEM strings must outlive the server. Accepts an RSA or EC key.
+    bool setCertificate(const char* certPem, const char* keyPem);
+#endif
+    // A client is waiting to be accepted (and, with TLS, to handshake).
+    bool hasPendingClient() { return _web.getServer().hasClient(); }
+
+    void collectHeaders(const char** keys, size_t count);
+    void on(const char* path, Handler handler);
+    void onNotFound(Handler handler);
+    // Multipart POST; upload sees each chunk as it arrives, then handler
+    // runs once to send the response.
+    void onUpload(const char* path, Handler handler, UploadHandler upload);
+
+    void begin(uint16_t port);
+    void update();
+    void stop();
+
+    uint8_t getEventStreamCount();
+    void sendEvent(const char* event, const char* data, uint32_t id);
+    void sendComment(const char* comment);
+
+private:
+    friend class SyncHttpRequest;
+
+    SyncWebServer _web;
+    SyncWebClient _streams[MAX_EVENT_STREAMS];
+    uintptr_t _uploadId;
+    bool _uploading;
+#if LOVI_TLS
+    BearSSL::X509List _certificate;
+    BearSSL::PrivateKey _key;
+    // Session IDs let a returning client skip the full handshake.
+    BearSSL::ServerSession _sessionStore[TLS_SESSION_CACHE_SIZE];
+    BearSSL::ServerSessions _sessions;
+#endif
+
+    bool _acceptEventStream();
+    void _writeEventStreams(const char* frame, size_t length);
+};
+
+}
@@ -0,0 +1,47 @@
+#include "Telemetry.h"
+
+namespace lovi {
+
+static int32_t _toFixed(float value, float scale, int32_t minValue, int32_t maxValue) {
+    float scaled = value * scale;
+    int32_t fixed = static_cast<int32_t>(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+    if (fixed < minValue) return minValue;
+    if (fixed > maxValue) return maxValue;
+    return fixed;
+}
+
+static uint8_t* _put16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+    return out + 2;
+}
+
+static uint8_t* _put32(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = value >> 24;
+    return out + 4;
+}
+
+size_t encodeTelemetry(const SensorData& data, uint32_t sequence, uint8_t changedFields,
+                       uint8_t* buffer, size_t size) {
+    if (size < TELEMETRY_FRAME_SIZE) {
+        return 0;
+    }
+
+    uint8_t* out = buffer;
+    *out++ = TELEMETRY_VERSION;
+    *out++ = (data.presence ? 0x01 : 0) | (data.motion ? 0x02 : 0);
+    *out++ = changedFields;
+    *out++ = static_cast<uint8_t>(constrain(data.sensitivity, 0, 100));
+    out = _put32(out, sequence);
+    out = _put32(out, data.uptime);
+    out = _put16(out, _toFixed(data.distance, 1000.0f, 0, 0xFFFF));
+    out = _put16(out, _toFixed(data.temperature, 100.0f, -32768, 32767));
+    out = _put16(out, _toFixed(data.humidity, 100.0f, 0, 0xFFFF));
+
+    return out - buffer;
+}
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+#include "types.h"
+
+namespace lovi {
+
+// Fixed-layout little-endian encoding of SensorData (version 1, 18 bytes):
+//   u8  version          u8  flags (bit0 presence, bit1 motion)
+//   u8  changed fields   u8  sensitivity (%)
+//   u32 sequence         u32 uptime (s)
+//   u16 distance (mm)    i16 temperature (0.01 C)   u16 humidity (0.01 %)
+static const uint8_t TELEMETRY_VERSION = 1;
+static const size_t TELEMETRY_FRAME_SIZE = 18;
+static const char TELEMETRY_CONTENT_TYPE[] = "application/x-lovi-telemetry";
+
+size_t encodeTelemetry(const SensorData& data, uint32_t sequence, uint8_t changedFields,
+                       uint8_t* buffer, size_t size);
+
+}
@@ -18,15 +18,61 @@ struct DeviceInfo {
     String model;
     
     struct Capabilities {
-        bool hasPresence = false;
-        bool hasMotion = false;
-        bool hasTemperature = false;
-        bool hasHumidity = false;
-        bool hasSensitivity = false;
+        uint8_t sensors = 0;  // SensorField mask
         float maxDistance = 0.0f;
+
+        constexpr bool has(uint8_t field) const { return (sensors & field) != 0; }
     } capabilities;
 };
 
+// Computed once at boot and shared read-only with the network services.
+// `id` is the MAC without separators and doubles as the unique device ID.
+struct DeviceIdentity {
+    uint8_t mac[6] = {0};
+    char macAddress[18] = "";
+    char id[13] = "";
+    char hostname[32] = "";
+    const char* type = "unknown";
+};
+
+// Last successful association, used to skip the scan and DHCP on reconnect.
+struct NetworkCache {
+    bool valid = false;
+    uint8_t bssid[6] = {0, 0, 0, 0, 0, 0};
+    uint8_t channel = 0;
+    uint32_t ip = 0;
+    uint32_t gateway = 0;
+    uint32_t subnet = 0;
+    uint32_t dns = 0;
+};
+
+enum SensorField : uint8_t {
+    SENSOR_PRESENCE = 1 << 0,
+    SENSOR_MOTION = 1 << 1,
+    SENSOR_DISTANCE = 1 << 2,
+    SENSOR_SENSITIVITY = 1 << 3,
+    SENSOR_TEMPERATURE = 1 << 4,
+    SENSOR_HUMIDITY = 1 << 5,
+    SENSOR_UPTIME = 1 << 6,
+    SENSOR_ALL = 0x7F
+};
+
+// Minimum change from the last reported value before a field counts as changed.
+struct SensorDeadbands {
+    float distance = 0.05f;
+    float temperature = 0.1f;
+    float humidity = 0.5f;
+    uint32_t uptime = 60;
+};
+
+// User-adjustable settings; sensitivity is persisted by the application.
+struct DeviceSettings {
+    uint8_t sensitivity = 50;
+    bool ledEnabled = true;
+    uint8_t ledBrightness = 255;
+    bool broadcast = false;
+};
+
 struct SensorData {
     bool presence = false;
     bool motion = false;
@@ -35,6 +81,8 @@ struct SensorData {
     float temperature = 0.0f;
     float humidity = 0.0f;
     uint32_t uptime = 0;
+    // micros() of the presence/motion edge behind this sample, 0 if polled.
+    uint32_t edgeTimeUs = 0;
 };
 
 }
@@ -0,0 +1,102 @@
+#include "Bench.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Every heap allocation on the host goes through these, so a benchmark that
+// allocates per operation shows up here long before it fragments the
+// 40 KB ESP8266 heap.
+static uint64_t _allocations = 0;
+
+void* operator new(size_t size) {
+    _allocations++;
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    free(pointer);
+}
+
+namespace lovi {
+namespace bench {
+
+static const uint64_t MIN_RUN_NS = 200000000ULL;
+static const uint64_t MAX_ITERATIONS = 1ULL << 30;
+
+static Benchmark* _benchmarks = nullptr;
+
+Registrar::Registrar(Benchmark* benchmark) {
+    // Append so the report keeps source order.
+    Benchmark** tail = &_benchmarks;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = benchmark;
+}
+
+static uint64_t _timeNs(BenchFunction function, uint64_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    function(iterations);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+int runAll(const char* filter) {
+    int failures = 0;
+    printf("%-28s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+
+    for (Benchmark* benchmark = _benchmarks; benchmark; benchmark = benchmark->next) {
+        if (filter && !strstr(benchmark->name, filter)) {
+            continue;
+        }
+
+        // Grow the batch until one run is long enough to time reliably.
+        uint64_t iterations = 1;
+        uint64_t elapsedNs = _timeNs(benchmark->function, iterations);
+        while (elapsedNs < MIN_RUN_NS && iterations < MAX_ITERATIONS) {
+            iterations *= elapsedNs ? (MIN_RUN_NS / elapsedNs > 10 ? 10 : 2) : 10;
+            elapsedNs = _timeNs(benchmark->function, iterations);
+        }
+
+        // Allocations are counted on a separate fixed-size pass so one-off
+        // setup does not get averaged away by a long timing run.
+        uint64_t before = _allocations;
+        benchmark->function(1000);
+        double allocsPerOp = (_allocations - before) / 1000.0;
+
+        const char* verdict = "";
+        if (benchmark->requireNoAlloc && allocsPerOp > 0) {
+            verdict = "  FAIL: allocates";
+            failures++;
+        }
+        printf("%-28s %12llu %12.1f %12.3f%s\n", benchmark->name,
+               static_cast<unsigned long long>(iterations),
+               static_cast<double>(elapsedNs) / iterations, allocsPerOp, verdict);
+    }
+    return failures;
+}
+
+}
+}
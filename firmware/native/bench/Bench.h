@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lovi {
+namespace bench {
+
+typedef void (*BenchFunction)(uint64_t iterations);
+
+struct Benchmark {
+    const char* name;
+    BenchFunction function;
+    // Hot-path benchmarks fail the run if they allocate at all.
+    bool requireNoAlloc;
+    Benchmark* next;
+};
+
+struct Registrar {
+    Registrar(Benchmark* benchmark);
+};
+
+// Keeps the compiler from discarding a result the benchmark never reads.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+int runAll(const char* filter);
+
+}
+}
+
+#define LOVI_BENCH_REGISTER(name, requireNoAlloc)                                      \
+    static void bench_##name(uint64_t iterations);                                      \
+    static ::lovi::bench::Benchmark bench_##name##_entry = {#name, bench_##name,        \
+                                                           requireNoAlloc, nullptr};    \
+    static ::lovi::bench::Registrar bench_##name##_registrar(&bench_##name##_entry);    \
+    static void bench_##name(uint64_t iterations)
+
+// BENCHMARK(name) { for (uint64_t i = 0; i < iterations; i++) { ... } }
+#define BENCHMARK(name) LOVI_BENCH_REGISTER(name, true)
+// For setup-heavy paths where an allocation is reported but tolerated.
+#define BENCHMARK_ALLOWING_ALLOC(name) LOVI_BENCH_REGISTER(name, false)
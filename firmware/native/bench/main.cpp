@@ -0,0 +1,130 @@
+#include <Arduino.h>
+#include "Bench.h"
+#include "ConfigManager.h"
+#include "History.h"
+#include "RadarParser.h"
+#include "SignalFilter.h"
+#include "Telemetry.h"
+
+using namespace lovi;
+using lovi::bench::doNotOptimize;
+
+static const uint8_t BASIC_FRAME[] = {
+    0xF4, 0xF3, 0xF2, 0xF1, 0x0D, 0x00,
+    0x02, 0xAA, 0x02, 0x51, 0x00, 0x00, 0x00, 0x00, 0x3B, 0x00, 0x00, 0x55, 0x00,
+    0xF8, 0xF7, 0xF6, 0xF5
+};
+
+static const uint8_t ENGINEERING_FRAME[] = {
+    0xF4, 0xF3, 0xF2, 0xF1, 0x21, 0x00,
+    0x01, 0xAA, 0x03, 0x51, 0x00, 0x3C, 0x33, 0x00, 0x50, 0x3B, 0x00,
+    0x08, 0x08,
+    0x40, 0x38, 0x30, 0x28, 0x20, 0x18, 0x10, 0x08, 0x04,
+    0x04, 0x08, 0x10, 0x18, 0x20, 0x28, 0x30, 0x38, 0x40,
+    0x55, 0x00,
+    0xF8, 0xF7, 0xF6, 0xF5
+};
+
+static SensorData _sample(uint32_t i) {
+    SensorData data;
+    data.presence = (i & 8) != 0;
+    data.motion = (i & 4) != 0;
+    data.distance = (i % 500) / 100.0f;
+    data.temperature = 21.5f;
+    data.humidity = 40.0f;
+    data.uptime = i;
+    return data;
+}
+
+BENCHMARK(telemetry_encode) {
+    SensorData data = _sample(1);
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    for (uint64_t i = 0; i < iterations; i++) {
+        data.uptime = static_cast<uint32_t>(i);
+        doNotOptimize(encodeTelemetry(data, static_cast<uint32_t>(i), SENSOR_ALL, frame, sizeof(frame)));
+        doNotOptimize(frame);
+    }
+}
+
+BENCHMARK(radar_basic_frame) {
+    RadarParser parser;
+    for (uint64_t i = 0; i < iterations; i++) {
+        for (uint8_t byte : BASIC_FRAME) {
+            doNotOptimize(parser.feed(byte));
+        }
+    }
+    doNotOptimize(parser.getFrameCount());
+}
+
+BENCHMARK(radar_engineering_frame) {
+    RadarParser parser;
+    for (uint64_t i = 0; i < iterations; i++) {
+        for (uint8_t byte : ENGINEERING_FRAME) {
+            doNotOptimize(parser.feed(byte));
+        }
+    }
+    doNotOptimize(parser.getFrameCount());
+}
+
+BENCHMARK(sensor_filter_chain) {
+    SensorFilter filter;
+    for (uint64_t i = 0; i < iterations; i++) {
+        uint32_t nowMs = static_cast<uint32_t>(i * 50);
+        doNotOptimize(filter.distanceCm(static_cast<uint16_t>(100 + (i * 7) % 40)));
+        doNotOptimize(filter.presence((i & 16) != 0, nowMs));
+        doNotOptimize(filter.motion((i & 4) != 0, nowMs));
+    }
+}
+
+static History _history;
+
+BENCHMARK(history_record) {
+    _history.clear();
+    for (uint64_t i = 0; i < iterations; i++) {
+        uint32_t sequence = static_cast<uint32_t>(i + 1);
+        _history.record(sequence, _sample(sequence), SENSOR_PRESENCE, sequence * 100);
+    }
+    doNotOptimize(_history.size());
+}
+
+BENCHMARK(history_scan_full) {
+    _history.clear();
+    for (uint32_t sequence = 1; sequence <= History::CAPACITY; sequence++) {
+        _history.record(sequence, _sample(sequence), SENSOR_PRESENCE, sequence * 100);
+    }
+    HistoryEntry entry;
+    for (uint64_t i = 0; i < iterations; i++) {
+        History::Cursor cursor = _history.since(0);
+        while (cursor.next(entry)) {
+            doNotOptimize(entry);
+        }
+    }
+}
+
+// Each save lands in the next slot and erases the sector every SLOT_COUNT
+// saves, so this is the amortised cost of a settings change.
+BENCHMARK(config_save) {
+    ConfigManager config;
+    config.begin();
+    config.setSSID("lovi-bench");
+    config.setPassword("correct horse battery staple");
+    for (uint64_t i = 0; i < iterations; i++) {
+        config.setSensitivity(static_cast<uint8_t>(i % 100));
+        config.saveConfig();
+    }
+    doNotOptimize(config.getSensitivity());
+}
+
+BENCHMARK(config_load) {
+    ConfigManager config;
+    config.setSSID("lovi-bench");
+    config.saveConfig();
+    for (uint64_t i = 0; i < iterations; i++) {
+        config.loadConfig();
+        doNotOptimize(config.isConfigured());
+    }
+}
+
+int main(int argc, char** argv) {
+    return lovi::bench::runAll(argc > 1 ? argv[1] : nullptr) ? 1 : 0;
+}
@@ -0,0 +1,723 @@
+#include "FleetServer.h"
+#include "Telemetry.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <openssl/err.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+
+extern "C" {
+#include <user_interface.h>
+}
+
+namespace lovi {
+
+static const size_t MAX_REQUEST_SIZE = 8192;
+static const uint32_t HISTORY_DEFAULT_LIMIT = 128;
+static const uint32_t HISTORY_MAX_LIMIT = 512;
+static const uint32_t INFO_VERSION = 0x5153494d;
+
+static const char* _statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        default: return "Error";
+    }
+}
+
+static bool _setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool _queryArg(const std::string& query, const char* name, std::string& value) {
+    size_t nameLength = strlen(name);
+    size_t start = 0;
+    while (start <= query.size()) {
+        size_t end = query.find('&', start);
+        if (end == std::string::npos) {
+            end = query.size();
+        }
+        if (end - start > nameLength && query.compare(start, nameLength, name) == 0
+            && query[start + nameLength] == '=') {
+            value = query.substr(start + nameLength + 1, end - start - nameLength - 1);
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+static std::string _lower(std::string text) {
+    for (char& c : text) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+static void _appendf(std::string& out, const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length > 0) {
+        out.append(buffer, static_cast<size_t>(length) < sizeof(buffer) ? length : sizeof(buffer) - 1);
+    }
+}
+
+static size_t _skipSpace(const std::string& text, size_t position) {
+    while (position < text.size() && isspace(static_cast<unsigned char>(text[position]))) {
+        position++;
+    }
+    return position;
+}
+
+// Reads {"settings": {...}} with the keys APIServer::_applySettings()
+// accepts. Values are numbers or booleans; other keys are ignored.
+static bool _parseSettings(const std::string& body, DeviceSettings& settings) {
+    size_t position = body.find("\"settings\"");
+    if (position == std::string::npos) {
+        return false;
+    }
+    position = _skipSpace(body, position + 10);
+    if (position >= body.size() || body[position] != ':') {
+        return false;
+    }
+    position = _skipSpace(body, position + 1);
+    if (position >= body.size() || body[position] != '{') {
+        return false;
+    }
+
+    while (true) {
+        position = _skipSpace(body, position + 1);
+        if (position < body.size() && body[position] == '}') {
+            return true;
+        }
+        if (position >= body.size() || body[position] != '"') {
+            return false;
+        }
+        size_t keyEnd = body.find('"', position + 1);
+        if (keyEnd == std::string::npos) {
+            return false;
+        }
+        std::string key = body.substr(position + 1, keyEnd - position - 1);
+        position = _skipSpace(body, keyEnd + 1);
+        if (position >= body.size() || body[position] != ':') {
+            return false;
+        }
+        position = _skipSpace(body, position + 1);
+        size_t valueEnd = body.find_first_of(",} \t\r\n", position);
+        if (valueEnd == std::string::npos) {
+            return false;
+        }
+        std::string value = body.substr(position, valueEnd - position);
+
+        long number;
+        if (value == "true" || value == "false") {
+            number = value == "true";
+        } else {
+            char* end;
+            number = strtol(value.c_str(), &end, 10);
+            if (value.empty() || *end) {
+                return false;
+            }
+        }
+        if (key == "sensitivity") {
+            settings.sensitivity = constrain(number, 0, 100);
+        } else if (key == "led") {
+            settings.ledEnabled = number != 0;
+        } else if (key == "led_brightness") {
+            settings.ledBrightness = constrain(number, 0, 255);
+        } else if (key == "broadcast") {
+            settings.broadcast = number != 0;
+        }
+
+        position = _skipSpace(body, valueEnd);
+        if (position < body.size() && body[position] == '}') {
+            return true;
+        }
+        if (position >= body.size() || body[position] != ',') {
+            return false;
+        }
+    }
+}
+
+FleetServer::FleetServer(std::vector<SimDevice>& devices, uint16_t basePort, uint32_t responseDelayMs)
+    : _devices(devices)
+    , _basePort(basePort)
+    , _responseDelayMs(responseDelayMs)
+    , _bootTag(static_cast<uint32_t>(time(nullptr)))
+    , _tls(nullptr) {
+}
+
+FleetServer::~FleetServer() {
+    for (int fd : _listeners) {
+        close(fd);
+    }
+    for (Connection& connection : _connections) {
+        _close(connection);
+    }
+    if (_tls) {
+        SSL_CTX_free(_tls);
+    }
+}
+
+// Limited to what BearSSL offers the device: TLS 1.2 and session IDs, no tickets.
+bool FleetServer::setCertificate(const char* certPath, const char* keyPath) {
+    static const unsigned char sessionContext[] = "lovi-fleet";
+
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    if (!context
+        || SSL_CTX_use_certificate_chain_file(context, certPath) != 1
+        || SSL_CTX_use_PrivateKey_file(context, keyPath, SSL_FILETYPE_PEM) != 1
+        || SSL_CTX_check_private_key(context) != 1) {
+        fprintf(stderr, "Invalid TLS certificate or key\n");
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(context);
+        return false;
+    }
+    SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION);
+    SSL_CTX_set_options(context, SSL_OP_NO_TICKET);
+    SSL_CTX_set_mode(context, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    SSL_CTX_set_session_id_context(context, sessionContext, sizeof(sessionContext) - 1);
+    SSL_CTX_sess_set_cache_size(context, TLS_SESSION_CACHE_SIZE * _devices.size());
+
+    if (_tls) {
+        SSL_CTX_free(_tls);
+    }
+    _tls = context;
+    return true;
+}
+
+bool FleetServer::begin() {
+    for (size_t i = 0; i < _devices.size(); i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(static_cast<uint16_t>(_basePort + i));
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+            || listen(fd, 16) != 0 || !_setNonBlocking(fd)) {
+            fprintf(stderr, "Cannot listen on port %u: %s\n",
+                    static_cast<unsigned>(_basePort + i), strerror(errno));
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        _listeners.push_back(fd);
+    }
+    return true;
+}
+
+void FleetServer::update(int timeoutMs) {
+    std::vector<pollfd> fds;
+    fds.reserve(_listeners.size() + _connections.size());
+    for (int fd : _listeners) {
+        fds.push_back({fd, POLLIN, 0});
+    }
+
+    uint32_t nowMs = millis();
+    for (const Connection& connection : _connections) {
+        short events = POLLIN;
+        if (connection.tlsWantsWrite) {
+            events |= POLLOUT;
+        } else if (!connection.output.empty()) {
+            if (static_cast<int32_t>(nowMs - connection.readyAtMs) >= 0) {
+                events |= POLLOUT;
+            } else if (static_cast<int>(connection.readyAtMs - nowMs) < timeoutMs) {
+                timeoutMs = static_cast<int>(connection.readyAtMs - nowMs);
+            }
+        }
+        fds.push_back({connection.fd, events, 0});
+    }
+
+    if (poll(fds.data(), fds.size(), timeoutMs) < 0) {
+        return;
+    }
+
+    // Connections accepted below are only polled from the next round.
+    size_t existing = _connections.size();
+    for (size_t i = 0; i < _listeners.size(); i++) {
+        if (fds[i].revents & POLLIN) {
+            _accept(i);
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < _connections.size(); i++) {
+        Connection& connection = _connections[i];
+        bool open = true;
+        if (i < existing) {
+            short revents = fds[_listeners.size() + i].revents;
+            open = !revents || _service(connection, revents);
+        }
+        if (open) {
+            if (kept != i) {
+                _connections[kept] = std::move(connection);
+            }
+            kept++;
+        } else {
+            _close(connection);
+        }
+    }
+    _connections.resize(kept);
+}
+
+void FleetServer::_accept(size_t device) {
+    while (true) {
+        int fd = accept(_listeners[device], nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        _setNonBlocking(fd);
+
+        SSL* tls = nullptr;
+        if (_tls) {
+            tls = SSL_new(_tls);
+            SSL_set_fd(tls, fd);
+            SSL_set_accept_state(tls);
+        }
+        _connections.push_back({fd, device, tls, tls != nullptr, false, std::string(), std::string(), 0, false});
+    }
+}
+
+bool FleetServer::_service(Connection& connection, short revents) {
+    if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+        return false;
+    }
+
+    connection.tlsWantsWrite = false;
+    if (connection.handshaking) {
+        int result = SSL_do_handshake(connection.tls);
+        if (result != 1) {
+            return _tlsRetry(connection, result);
+        }
+        connection.handshaking = false;
+    }
+
+    // TLS may hold decrypted bytes the socket no longer signals.
+    if ((revents & POLLIN || connection.tls) && !_read(connection)) {
+        return false;
+    }
+    if (!connection.output.empty() && static_cast<int32_t>(millis() - connection.readyAtMs) >= 0) {
+        return _write(connection);
+    }
+    return true;
+}
+
+// True when the TLS call only needs the socket to become ready again.
+bool FleetServer::_tlsRetry(Connection& connection, int result) {
+    switch (SSL_get_error(connection.tls, result)) {
+        case SSL_ERROR_WANT_READ:
+            return true;
+        case SSL_ERROR_WANT_WRITE:
+            connection.tlsWantsWrite = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void FleetServer::_close(Connection& connection) {
+    if (connection.tls) {
+        SSL_shutdown(connection.tls);
+        SSL_free(connection.tls);
+        connection.tls = nullptr;
+    }
+    close(connection.fd);
+}
+
+bool FleetServer::_read(Connection& connection) {
+    char buffer[4096];
+    while (true) {
+        ssize_t received;
+        if (connection.tls) {
+            received = SSL_read(connection.tls, buffer, sizeof(buffer));
+            if (received <= 0) {
+                if (!_tlsRetry(connection, received)) {
+                    return false;
+                }
+                break;
+            }
+        } else {
+            received = recv(connection.fd, buffer, sizeof(buffer), 0);
+            if (received == 0) {
+                return false;
+            }
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    return false;
+                }
+                break;
+            }
+        }
+        // Like the device, anything after the first request is never read.
+        if (connection.answered) {
+            continue;
+        }
+        connection.input.append(buffer, received);
+        if (connection.input.size() > MAX_REQUEST_SIZE) {
+            return false;
+        }
+    }
+
+    if (!connection.answered) {
+        _parse(connection);
+    }
+    return true;
+}
+
+// Returns false once the response is out: the device closes every
+// connection after one response.
+bool FleetServer::_write(Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t sent;
+        if (connection.tls) {
+            sent = SSL_write(connection.tls, connection.output.data(), connection.output.size());
+            if (sent <= 0) {
+                return _tlsRetry(connection, sent);
+            }
+        } else {
+            sent = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+            if (sent < 0) {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+        }
+        connection.output.erase(0, sent);
+    }
+    return false;
+}
+
+void FleetServer::_parse(Connection& connection) {
+    size_t headerEnd = connection.input.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        return;
+    }
+
+    Request request;
+    request.hasApiKey = false;
+    size_t contentLength = 0;
+
+    size_t lineEnd = connection.input.find("\r\n");
+    std::string line = connection.input.substr(0, lineEnd);
+    size_t methodEnd = line.find(' ');
+    size_t targetEnd = line.find(' ', methodEnd + 1);
+    if (methodEnd == std::string::npos || targetEnd == std::string::npos) {
+        connection.answered = true;
+        connection.input.clear();
+        _send(connection, 400, "text/plain", "", 0);
+        return;
+    }
+    request.method = line.substr(0, methodEnd);
+    std::string target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+    size_t queryStart = target.find('?');
+    request.path = target.substr(0, queryStart);
+    if (queryStart != std::string::npos) {
+        request.query = target.substr(queryStart + 1);
+    }
+
+    size_t position = lineEnd + 2;
+    while (position < headerEnd) {
+        lineEnd = connection.input.find("\r\n", position);
+        line = connection.input.substr(position, lineEnd - position);
+        position = lineEnd + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = _lower(line.substr(0, colon));
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        std::string value = valueStart == std::string::npos ? "" : line.substr(valueStart);
+        if (name == "accept") {
+            request.accept = value;
+        } else if (name == "if-none-match") {
+            request.ifNoneMatch = value;
+        } else if (name == "x-api-key") {
+            request.apiKey = value;
+            request.hasApiKey = true;
+        } else if (name == "content-length") {
+            contentLength = strtoul(value.c_str(), nullptr, 10);
+        }
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    if (connection.input.size() < bodyStart + contentLength) {
+        return;
+    }
+    request.body = connection.input.substr(bodyStart, contentLength);
+    connection.input.clear();
+
+    connection.answered = true;
+    connection.readyAtMs = millis() + _responseDelayMs;
+    _handle(connection, request);
+}
+
+void FleetServer::_handle(Connection& connection, const Request& request) {
+    SimDevice& device = _devices[connection.device];
+    Metrics& metrics = device.getMetrics();
+    uint32_t start = ESP.getCycleCount();
+    metrics.countRequest();
+
+    // /api/device stays open so discovery can identify the device without a key.
+    if (request.path != "/api/device" && !_apiKey.empty() && !_authorized(request)) {
+        static const char body[] = "{\"error\":\"Unauthorized\"}";
+        _send(connection, 401, "application/json", body, sizeof(body) - 1);
+    } else if (request.path == "/api/device") {
+        _handleDevice(connection, request, device);
+    } else if (request.path == "/api/data") {
+        _handleData(connection, request, device);
+    } else if (request.path == "/api/state") {
+        _handleState(connection, request, device);
+    } else if (request.path == "/api/metrics") {
+        _handleMetrics(connection, device);
+    } else if (request.path == "/api/history") {
+        _handleHistory(connection, request, device);
+    } else {
+        // No /api/stream either, so the integration falls back to polling.
+        static const char body[] = "{\"error\":\"Not found\"}";
+        metrics.countNotFound();
+        _send(connection, 404, "application/json", body, sizeof(body) - 1);
+    }
+
+    metrics.record(device.getRequestProbe(), ESP.getCycleCount() - start);
+}
+
+bool FleetServer::_authorized(const Request& request) const {
+    return request.hasApiKey && request.apiKey == _apiKey;
+}
+
+void FleetServer::_handleDevice(Connection& connection, const Request& request, SimDevice& device) {
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%08x\"", static_cast<unsigned>(INFO_VERSION));
+    if (_notModified(connection, request, device, etag)) {
+        return;
+    }
+
+    char body[384];
+    size_t length = _renderInfo(device, body, sizeof(body));
+    char headers[48];
+    snprintf(headers, sizeof(headers), "ETag: %s\r\n", etag);
+    _send(connection, 200, "application/json", body, length, headers);
+}
+
+void FleetServer::_handleData(Connection& connection, const Request& request, SimDevice& device) {
+    bool binary = request.accept.find(TELEMETRY_CONTENT_TYPE) != std::string::npos;
+
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%08x-%u%s\"", static_cast<unsigned>(_bootTag),
+             static_cast<unsigned>(device.getSequence()), binary ? "b" : "");
+    if (_notModified(connection, request, device, etag)) {
+        return;
+    }
+
+    char headers[64];
+    snprintf(headers, sizeof(headers), "ETag: %s\r\nVary: Accept\r\n", etag);
+    if (binary) {
+        uint8_t frame[TELEMETRY_FRAME_SIZE];
+        size_t length = encodeTelemetry(device.getSensorData(), device.getSequence(),
+                                        device.getChangedFields(), frame, sizeof(frame));
+        _send(connection, 200, TELEMETRY_CONTENT_TYPE, reinterpret_cast<const char*>(frame), length, headers);
+        return;
+    }
+
+    char body[256];
+    size_t length = _renderData(device, body, sizeof(body));
+    _send(connection, 200, "application/json", body, length, headers);
+}
+
+void FleetServer::_handleState(Connection& connection, const Request& request, SimDevice& device) {
+    bool post = request.method == "POST";
+    if (post) {
+        DeviceSettings settings = device.getSettings();
+        if (!_parseSettings(request.body, settings)) {
+            static const char body[] = "{\"error\":\"Invalid settings\"}";
+            _send(connection, 400, "application/json", body, sizeof(body) - 1);
+            return;
+        }
+        device.applySettings(settings);
+    }
+
+    char infoVersion[9];
+    snprintf(infoVersion, sizeof(infoVersion), "%08x", static_cast<unsigned>(INFO_VERSION));
+    std::string value;
+    bool sendInfo = post || !_queryArg(request.query, "info", value) || value != infoVersion;
+    bool sendSettings = post || !_queryArg(request.query, "settings", value)
+        || strtoul(value.c_str(), nullptr, 10) != device.getSettingsVersion();
+
+    char info[384];
+    char data[256];
+    char settings[128];
+    if (sendInfo) {
+        _renderInfo(device, info, sizeof(info));
+    } else {
+        strcpy(info, "null");
+    }
+    _renderData(device, data, sizeof(data));
+    if (sendSettings) {
+        _renderSettings(device, settings, sizeof(settings));
+    } else {
+        strcpy(settings, "null");
+    }
+
+    char body[896];
+    size_t length = snprintf(body, sizeof(body),
+        "{\"versions\":{\"info\":\"%s\",\"data\":%u,\"settings\":%u},"
+        "\"info\":%s,\"data\":%s,\"settings\":%s}",
+        infoVersion, static_cast<unsigned>(device.getSequence()),
+        static_cast<unsigned>(device.getSettingsVersion()), info, data, settings);
+    _send(connection, 200, "application/json", body, length);
+}
+
+// Same layout as APIServer::_handleMetrics(), filled from the device's
+// Metrics. The host has no ESP heap or radio, so those read as an idle
+// device would.
+void FleetServer::_handleMetrics(Connection& connection, SimDevice& device) {
+    Metrics& metrics = device.getMetrics();
+    std::string body;
+    _appendf(body, "{\"uptime\":%u,\"heap\":{\"free\":28000,\"max_block\":24000,\"fragmentation\":8},"
+             "\"wifi\":{\"rssi\":-60},",
+             static_cast<unsigned>(millis() / 1000));
+    _appendf(body, "\"http\":{\"requests\":%u,\"not_modified\":%u,\"not_found\":%u,\"stream_clients\":0},",
+             static_cast<unsigned>(metrics.getRequestCount()),
+             static_cast<unsigned>(metrics.getNotModifiedCount()),
+             static_cast<unsigned>(metrics.getNotFoundCount()));
+
+    uint16_t dutyCycle = metrics.getDutyCyclePermille();
+    _appendf(body, "\"power\":{\"mode\":\"%s\",\"duty_cycle\":%u.%u,\"busy_ms\":%u,\"idle_ms\":%u},",
+             metrics.getPowerMode(), dutyCycle / 10, dutyCycle % 10,
+             static_cast<unsigned>(metrics.getBusyMs()), static_cast<unsigned>(metrics.getIdleMs()));
+    _appendf(body, "\"cpu\":{\"mhz\":%u,\"boosts\":%u,\"boosted_ms\":%u,\"last_switch\":%u,"
+             "\"last_demand\":[]},",
+             static_cast<unsigned>(system_get_cpu_freq()),
+             static_cast<unsigned>(metrics.getCpuBoostCount()),
+             static_cast<unsigned>(metrics.getCpuBoostedMs()),
+             static_cast<unsigned>(metrics.getCpuLastSwitchMs() / 1000));
+
+    body += "\"histogram_limits_us\":[";
+    for (uint8_t b = 0; b < LatencyStats::BUCKETS - 1; b++) {
+        _appendf(body, "%s%u", b ? "," : "", static_cast<unsigned>(LatencyStats::bucketLimitUs(b)));
+    }
+
+    body += "],\"tasks\":{";
+    for (uint8_t i = 0; i < metrics.getProbeCount(); i++) {
+        const LatencyStats* stats = metrics.getProbeStats(i);
+        _appendf(body, "%s\"%s\":{\"count\":%u,\"min_us\":%u,\"max_us\":%u,\"mean_us\":%u,\"histogram\":[",
+                 i ? "," : "", metrics.getProbeName(i),
+                 static_cast<unsigned>(stats->count), static_cast<unsigned>(stats->minUs),
+                 static_cast<unsigned>(stats->maxUs), static_cast<unsigned>(stats->meanUs()));
+        for (uint8_t b = 0; b < LatencyStats::BUCKETS; b++) {
+            _appendf(body, "%s%u", b ? "," : "", static_cast<unsigned>(stats->histogram[b]));
+        }
+        body += "]}";
+    }
+    body += "}}";
+    _send(connection, 200, "application/json", body.data(), body.size());
+}
+
+void FleetServer::_handleHistory(Connection& connection, const Request& request, SimDevice& device) {
+    const History& history = device.getHistory();
+    std::string value;
+    uint32_t since = _queryArg(request.query, "since", value) ? strtoul(value.c_str(), nullptr, 10) : 0;
+    uint32_t limit = _queryArg(request.query, "limit", value) ? strtoul(value.c_str(), nullptr, 10) : 0;
+    if (limit == 0) {
+        limit = HISTORY_DEFAULT_LIMIT;
+    } else if (limit > HISTORY_MAX_LIMIT) {
+        limit = HISTORY_MAX_LIMIT;
+    }
+
+    std::string body;
+    _appendf(body, "{\"now_ms\":%u,\"oldest\":%u,\"newest\":%u,\"truncated\":%s,\"entries\":[",
+             static_cast<unsigned>(millis()),
+             static_cast<unsigned>(history.getOldestSequence()),
+             static_cast<unsigned>(history.isEmpty() ? 0 : history.getNewestSequence()),
+             !history.isEmpty() && since + 1 < history.getOldestSequence() ? "true" : "false");
+
+    History::Cursor cursor = history.since(since);
+    HistoryEntry entry;
+    uint32_t count = 0;
+    uint32_t last = since;
+    while (count < limit && cursor.next(entry)) {
+        _appendf(body, "%s[%u,%u,%u,%u,%u]",
+                 count ? "," : "",
+                 static_cast<unsigned>(entry.sequence),
+                 static_cast<unsigned>(entry.timeMs),
+                 (entry.presence ? 1 : 0) | (entry.presenceEdge ? 2 : 0),
+                 (entry.motion ? 1 : 0) | (entry.motionEdge ? 2 : 0),
+                 static_cast<unsigned>(entry.distance * 100.0f + 0.5f));
+        last = entry.sequence;
+        count++;
+    }
+    _appendf(body, "],\"next\":%u}", static_cast<unsigned>(last));
+    _send(connection, 200, "application/json", body.data(), body.size());
+}
+
+bool FleetServer::_notModified(Connection& connection, const Request& request, SimDevice& device,
+                               const char* etag) {
+    if (request.ifNoneMatch.empty()
+        || (request.ifNoneMatch.find(etag) == std::string::npos && request.ifNoneMatch != "*")) {
+        return false;
+    }
+
+    device.getMetrics().countNotModified();
+    char headers[48];
+    snprintf(headers, sizeof(headers), "ETag: %s\r\n", etag);
+    _send(connection, 304, nullptr, "", 0, headers);
+    return true;
+}
+
+void FleetServer::_send(Connection& connection, int status, const char* contentType,
+                        const char* body, size_t length, const char* extraHeaders) {
+    char header[256];
+    int headerLength = snprintf(header, sizeof(header), "HTTP/1.1 %d %s\r\n%s%s%s%s"
+                                "Content-Length: %u\r\nConnection: close\r\n\r\n",
+                                status, _statusText(status),
+                                contentType ? "Content-Type: " : "",
+                                contentType ? contentType : "",
+                                contentType ? "\r\n" : "",
+                                extraHeaders, static_cast<unsigned>(length));
+    connection.output.append(header, headerLength);
+    connection.output.append(body, length);
+}
+
+size_t FleetServer::_renderInfo(const SimDevice& device, char* buffer, size_t size) {
+    return snprintf(buffer, size,
+        "{\"id\":\"%s\",\"name\":\"%s\",\"type\":\"presence_gen_one\",\"firmware_version\":\"sim\","
+        "\"capabilities\":{\"has_presence\":true,\"has_motion\":true,\"has_temperature\":true,"
+        "\"has_humidity\":true,\"has_sensitivity\":true,\"max_distance\":5}}",
+        device.getId(), device.getHostname());
+}
+
+size_t FleetServer::_renderData(const SimDevice& device, char* buffer, size_t size) {
+    const SensorData& data = device.getSensorData();
+    return snprintf(buffer, size,
+        "{\"presence\":%s,\"motion\":%s,\"distance\":%.2f,\"sensitivity\":%d,"
+        "\"temperature\":%.1f,\"humidity\":%.1f,\"uptime\":%u,\"seq\":%u}",
+        data.presence ? "true" : "false", data.motion ? "true" : "false",
+        data.distance, data.sensitivity, data.temperature, data.humidity,
+        static_cast<unsigned>(data.uptime), static_cast<unsigned>(device.getSequence()));
+}
+
+size_t FleetServer::_renderSettings(const SimDevice& device, char* buffer, size_t size) {
+    const DeviceSettings& settings = device.getSettings();
+    return snprintf(buffer, size,
+        "{\"sensitivity\":%u,\"led\":%s,\"led_brightness\":%u,\"broadcast\":%s}",
+        static_cast<unsigned>(settings.sensitivity), settings.ledEnabled ? "true" : "false",
+        static_cast<unsigned>(settings.ledBrightness), settings.broadcast ? "true" : "false");
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include <openssl/ssl.h>
+#include <string>
+#include <vector>
+#include "SimDevice.h"
+
+namespace lovi {
+
+// Serves the lovi-core HTTP API for a fleet of SimDevices, one listening
+// port per device, from a single poll() loop. Responses mirror APIServer's
+// wire format, including ETags, 304s and binary telemetry, and its
+// transport: one request per connection, the X-API-Key check and
+// optionally TLS, so the Home Assistant client pays the same connection
+// costs it does against hardware.
+class FleetServer {
+public:
+    // Matches SyncHttpServer's BearSSL session cache, per device.
+    static const uint8_t TLS_SESSION_CACHE_SIZE = 4;
+
+    FleetServer(std::vector<SimDevice>& devices, uint16_t basePort, uint32_t responseDelayMs);
+    ~FleetServer();
+
+    // An empty key leaves every endpoint open, as on an unprovisioned device.
+    void setApiKey(const char* apiKey) { _apiKey = apiKey ? apiKey : ""; }
+    // PEM files; RSA or EC keys. Call before begin().
+    bool setCertificate(const char* certPath, const char* keyPath);
+
+    bool begin();
+    // Services sockets for up to timeoutMs.
+    void update(int timeoutMs);
+
+private:
+    struct Connection {
+        int fd;
+        size_t device;
+        SSL* tls;
+        bool handshaking;
+        bool tlsWantsWrite;
+        std::string input;
+        std::string output;
+        uint32_t readyAtMs;
+        bool answered;
+    };
+
+    struct Request {
+        std::string method;
+        std::string path;
+        std::string query;
+        std::string accept;
+        std::string ifNoneMatch;
+        std::string apiKey;
+        bool hasApiKey;
+        std::string body;
+    };
+
+    std::vector<SimDevice>& _devices;
+    uint16_t _basePort;
+    uint32_t _responseDelayMs;
+    uint32_t _bootTag;
+    std::string _apiKey;
+    SSL_CTX* _tls;
+    std::vector<int> _listeners;
+    std::vector<Connection> _connections;
+
+    void _accept(size_t device);
+    bool _service(Connection& connection, short revents);
+    bool _read(Connection& connection);
+    bool _write(Connection& connection);
+    bool _tlsRetry(Connection& connection, int result);
+    void _close(Connection& connection);
+    void _parse(Connection& connection);
+    void _handle(Connection& connection, const Request& request);
+
+    void _handleDevice(Connection& connection, const Request& request, SimDevice& device);
+    void _handleData(Connection& connection, const Request& request, SimDevice& device);
+    void _handleState(Connection& connection, const Request& request, SimDevice& device);
+    void _handleMetrics(Connection& connection, SimDevice& device);
+    void _handleHistory(Connection& connection, const Request& request, SimDevice& device);
+
+    bool _authorized(const Request& request) const;
+    bool _notModified(Connection& connection, const Request& request, SimDevice& device,
+                      const char* etag);
+    void _send(Connection& connection, int status, const char* contentType,
+               const char* body, size_t length, const char* extraHeaders = "");
+
+    size_t _renderInfo(const SimDevice& device, char* buffer, size_t size);
+    size_t _renderData(const SimDevice& device, char* buffer, size_t size);
+    size_t _renderSettings(const SimDevice& device, char* buffer, size_t size);
+};
+
+}
@@ -0,0 +1,80 @@
+#include "SimDevice.h"
+#include <cstdio>
+
+namespace lovi {
+
+// Mean time between simulated state changes.
+static const uint32_t STEP_MS = 2000;
+
+SimDevice::SimDevice(uint16_t index, uint32_t seed)
+    : _random(seed ? seed : 1)
+    , _nextStepMs(0)
+    , _sequence(0)
+    , _settingsVersion(0)
+    , _changedFields(0)
+    , _requestProbe(_metrics.addProbe("http")) {
+    // Locally administered MACs, so simulated IDs never collide with hardware.
+    snprintf(_id, sizeof(_id), "02AB%08X", static_cast<unsigned>(index));
+    snprintf(_hostname, sizeof(_hostname), "lovi-sim-%04u", static_cast<unsigned>(index));
+    _data.distance = 1.5f;
+    _data.temperature = 21.0f;
+    _data.humidity = 45.0f;
+}
+
+uint32_t SimDevice::_next() {
+    // xorshift32, one independent stream per device.
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
+
+void SimDevice::update(uint32_t nowMs) {
+    _data.uptime = nowMs / 1000;
+    if (static_cast<int32_t>(nowMs - _nextStepMs) < 0) {
+        return;
+    }
+    _nextStepMs = nowMs + STEP_MS / 2 + _next() % STEP_MS;
+
+    uint8_t changed = 0;
+    uint32_t roll = _next();
+    if (roll % 8 == 0) {
+        _data.presence = !_data.presence;
+        changed |= SENSOR_PRESENCE;
+    }
+    if (roll % 3 == 0) {
+        _data.motion = _data.presence && !_data.motion;
+        changed |= SENSOR_MOTION;
+    }
+    if (_data.presence) {
+        float step = (static_cast<int32_t>(_next() % 41) - 20) / 100.0f;
+        float distance = _data.distance + step;
+        _data.distance = distance < 0.3f ? 0.3f : (distance > 5.0f ? 5.0f : distance);
+        changed |= SENSOR_DISTANCE;
+    }
+
+    if (changed) {
+        _sequence++;
+        _changedFields = changed;
+        _history.record(_sequence, _data, changed, nowMs);
+    }
+}
+
+bool SimDevice::applySettings(const DeviceSettings& settings) {
+    DeviceSettings next = settings;
+    next.sensitivity = next.sensitivity > 100 ? 100 : next.sensitivity;
+
+    if (next.sensitivity == _settings.sensitivity
+        && next.ledEnabled == _settings.ledEnabled
+        && next.ledBrightness == _settings.ledBrightness
+        && next.broadcast == _settings.broadcast) {
+        return false;
+    }
+
+    _settings = next;
+    _data.sensitivity = next.sensitivity;
+    _settingsVersion++;
+    return true;
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include "History.h"
+#include "Metrics.h"
+#include "types.h"
+
+namespace lovi {
+
+// Host stand-in for one presence sensor: a random walk over presence,
+// motion and distance that feeds the real History ring and Metrics.
+class SimDevice {
+public:
+    SimDevice(uint16_t index, uint32_t seed);
+
+    void update(uint32_t nowMs);
+
+    const char* getId() const { return _id; }
+    const char* getHostname() const { return _hostname; }
+    const SensorData& getSensorData() const { return _data; }
+    const DeviceSettings& getSettings() const { return _settings; }
+    const History& getHistory() const { return _history; }
+    uint32_t getSequence() const { return _sequence; }
+    uint32_t getSettingsVersion() const { return _settingsVersion; }
+    uint8_t getChangedFields() const { return _changedFields; }
+    Metrics& getMetrics() { return _metrics; }
+    int8_t getRequestProbe() const { return _requestProbe; }
+
+    // Same rules as Device::applySettings().
+    bool applySettings(const DeviceSettings& settings);
+
+private:
+    char _id[13];
+    char _hostname[32];
+    uint32_t _random;
+    uint32_t _nextStepMs;
+    SensorData _data;
+    DeviceSettings _settings;
+    History _history;
+    uint32_t _sequence;
+    uint32_t _settingsVersion;
+    uint8_t _changedFields;
+    Metrics _metrics;
+    int8_t _requestProbe;
+
+    uint32_t _next();
+};
+
+}
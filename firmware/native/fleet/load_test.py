@@ -0,0 +1,394 @@
+"""Fleet load test for the Lovi integration's polling path.
+
+Starts the native fleet simulator (one simulated device per TCP port) and
+polls every device with the integration's ``SecureApiClient`` the way
+``LoviDataUpdateCoordinator`` does: a combined state request first and
+every tenth refresh, binary telemetry in between, a history backfill when
+the sequence number jumped and metrics with every state request. The device count is ramped
+in steps and each step reports client-side poll latency, process CPU use
+and event loop lag.
+
+Like the firmware, the simulator closes every connection after its
+response. ``--api-key`` makes it require the key and ``--https`` serves
+TLS 1.2 with a throwaway self-signed certificate (needs the ``openssl``
+command line tool), so the cost of a handshake per request is measured
+too.
+
+Run it from a Home Assistant development environment, since the API
+client imports ``homeassistant`` and ``aiohttp``:
+
+    pio run -d firmware/native -e fleet
+    python3 firmware/native/fleet/load_test.py --steps 100,200,300,400,500
+
+Example:
+    python3 load_test.py --steps 50,100 --duration 30 --interval 10
+"""
+
+from __future__ import annotations
+
+import argparse
+import asyncio
+import importlib.util
+import random
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from types import ModuleType
+
+import aiohttp
+
+REPO_ROOT = Path(__file__).resolve().parents[3]
+DEFAULT_SIMULATOR = REPO_ROOT / "firmware" / "native" / ".pio" / "build" / "fleet" / "program"
+
+# Mirrors LoviDataUpdateCoordinator, which cannot be imported without a
+# running Home Assistant instance.
+UPDATE_INTERVAL = 30  # seconds
+METRICS_REFRESH_EVERY = 10
+
+LOOP_LAG_PERIOD = 0.05  # seconds
+ZEROCONF_SERVICE_TYPE = "_lovi._tcp.local."
+
+
+def _load_api() -> ModuleType:
+    """Import the integration's api package without its parent package.
+
+    Returns:
+        The loaded api module
+    """
+    spec = importlib.util.spec_from_file_location(
+        "lovi_api",
+        REPO_ROOT / "api" / "__init__.py",
+        submodule_search_locations=[str(REPO_ROOT / "api")],
+    )
+    module = importlib.util.module_from_spec(spec)
+    sys.modules["lovi_api"] = module
+    spec.loader.exec_module(module)
+    return module
+
+
+api = _load_api()
+
+
+@dataclass
+class PhaseStats:
+    """Measurements collected while the fleet size is constant.
+
+    Attributes:
+        latencies: Seconds per completed refresh
+        loop_lags: Seconds the event loop woke up late
+        errors: Refreshes that raised an API or connection error
+    """
+
+    latencies: list[float] = field(default_factory=list)
+    loop_lags: list[float] = field(default_factory=list)
+    errors: int = 0
+
+
+def _percentile(values: list[float], percent: float) -> float:
+    """Return the nearest-rank percentile of a list.
+
+    Args:
+        values: Samples, in any order
+        percent: Percentile between 0 and 100
+
+    Returns:
+        The percentile, or 0.0 for an empty list
+    """
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, max(0, round(percent / 100 * len(ordered)) - 1))
+    return ordered[index]
+
+
+class FleetLoadTest:
+    """Ramps the number of polled devices and reports each step."""
+
+    def __init__(self, args: argparse.Namespace) -> None:
+        """Initialize the load test.
+
+        Args:
+            args: Parsed command line arguments
+        """
+        self._args = args
+        self._phase = PhaseStats()
+        self._stop = asyncio.Event()
+        self._tasks: list[asyncio.Task] = []
+        self._session: aiohttp.ClientSession | None = None
+        self._simulator: asyncio.subprocess.Process | None = None
+        self._zeroconf = None
+        self._certificates: tempfile.TemporaryDirectory | None = None
+
+    async def run(self) -> None:
+        """Run every step and print one report line per step."""
+        steps = self._args.steps
+        if not self._args.no_spawn:
+            await self._start_simulator(max(steps))
+
+        # Sized like Home Assistant's shared client session.
+        connector = aiohttp.TCPConnector(limit=4096, limit_per_host=100)
+        self._session = aiohttp.ClientSession(connector=connector)
+        lag_task = asyncio.create_task(self._monitor_loop_lag())
+
+        print(
+            f"{'devices':>8} {'refreshes':>10} {'errors':>7} {'p50 ms':>8} "
+            f"{'p95 ms':>8} {'p99 ms':>8} {'cpu %':>7} {'lag p99':>8} {'lag max':>8}"
+        )
+        try:
+            for count in steps:
+                await self._grow_fleet(count)
+                self._phase = PhaseStats()
+                cpu_start = time.process_time()
+                wall_start = time.monotonic()
+                await asyncio.sleep(self._args.duration)
+                cpu = (time.process_time() - cpu_start) / (time.monotonic() - wall_start)
+                self._report(count, self._phase, cpu)
+        finally:
+            self._stop.set()
+            await asyncio.gather(*self._tasks, lag_task, return_exceptions=True)
+            await self._session.close()
+            await self._shutdown()
+
+    async def _start_simulator(self, devices: int) -> None:
+        """Launch the native fleet simulator and wait until it listens.
+
+        Args:
+            devices: Number of simulated devices
+        """
+        command = [
+            str(self._args.simulator),
+            "--devices",
+            str(devices),
+            "--port",
+            str(self._args.port),
+            "--delay-ms",
+            str(self._args.delay_ms),
+        ]
+        if self._args.api_key:
+            command += ["--api-key", self._args.api_key]
+        if self._args.https:
+            cert, key = self._create_certificate()
+            command += ["--tls-cert", cert, "--tls-key", key]
+
+        self._simulator = await asyncio.create_subprocess_exec(
+            *command, stdout=asyncio.subprocess.PIPE
+        )
+        line = await self._simulator.stdout.readline()
+        if not line.startswith(b"ready"):
+            raise RuntimeError("Fleet simulator failed to start")
+
+    def _create_certificate(self) -> tuple[str, str]:
+        """Write a self-signed EC certificate for the simulator.
+
+        Returns:
+            Paths of the certificate and key PEM files
+        """
+        self._certificates = tempfile.TemporaryDirectory()
+        cert = str(Path(self._certificates.name) / "cert.pem")
+        key = str(Path(self._certificates.name) / "key.pem")
+        subprocess.run(
+            ["openssl", "req", "-x509", "-newkey", "ec"]
+            + ["-pkeyopt", "ec_paramgen_curve:prime256v1", "-nodes", "-days", "1"]
+            + ["-subj", "/CN=lovi-sim", "-keyout", key, "-out", cert],
+            check=True,
+            capture_output=True,
+        )
+        return cert, key
+
+    async def _grow_fleet(self, count: int) -> None:
+        """Start pollers, and optionally mDNS records, up to a fleet size.
+
+        Args:
+            count: Total number of devices to poll from now on
+        """
+        for index in range(len(self._tasks), count):
+            port = self._args.port + index
+            client = api.SecureApiClient(
+                self._args.host,
+                port,
+                api.ApiCredentials(api_key=self._args.api_key),
+                use_https=self._args.https,
+                verify_ssl=False,
+                max_retries=1,
+            )
+            # Every coordinator shares Home Assistant's one client session.
+            client._session = self._session
+            self._tasks.append(asyncio.create_task(self._poll_device(client)))
+            if self._args.mdns:
+                await self._advertise(index, port)
+
+    async def _poll_device(self, client: api.SecureApiClient) -> None:
+        """Refresh one device like the coordinator does until stopped.
+
+        Args:
+            client: API client for the device
+        """
+        interval = self._args.interval
+        # Config entries finish setting up at different times.
+        if await self._wait_stop(random.uniform(0, interval)):
+            return
+
+        refresh_count = 0
+        last_seq: int | None = None
+        while not self._stop.is_set():
+            start = time.perf_counter()
+            try:
+                if refresh_count % METRICS_REFRESH_EVERY == 0:
+                    data = (await client.async_get_state())["data"]
+                else:
+                    data = await client.async_get_telemetry()
+
+                seq = data.get("seq")
+                if last_seq is not None and seq is not None and seq > last_seq + 1:
+                    await client.async_get_history(last_seq)
+                last_seq = seq
+
+                if refresh_count % METRICS_REFRESH_EVERY == 0:
+                    await client.async_get_metrics()
+                self._phase.latencies.append(time.perf_counter() - start)
+            except (api.LoviApiError, api.LoviConnectionError, api.LoviTimeoutError):
+                self._phase.errors += 1
+            refresh_count += 1
+
+            if await self._wait_stop(interval):
+                return
+
+    async def _wait_stop(self, delay: float) -> bool:
+        """Sleep unless the test is stopped first.
+
+        Args:
+            delay: Seconds to sleep
+
+        Returns:
+            True if the test was stopped
+        """
+        try:
+            await asyncio.wait_for(self._stop.wait(), delay)
+        except asyncio.TimeoutError:
+            return False
+        return True
+
+    async def _monitor_loop_lag(self) -> None:
+        """Record how late the event loop runs a periodic wakeup."""
+        loop = asyncio.get_running_loop()
+        while not self._stop.is_set():
+            start = loop.time()
+            await asyncio.sleep(LOOP_LAG_PERIOD)
+            self._phase.loop_lags.append(max(0.0, loop.time() - start - LOOP_LAG_PERIOD))
+
+    async def _advertise(self, index: int, port: int) -> None:
+        """Publish a simulated device over mDNS like MDNSAdvertiser does.
+
+        Args:
+            index: Device index in the simulator
+            port: Port the device listens on
+        """
+        # pylint: disable-next=import-outside-toplevel
+        from zeroconf.asyncio import AsyncServiceInfo, AsyncZeroconf
+
+        if self._zeroconf is None:
+            self._zeroconf = AsyncZeroconf()
+
+        hostname = f"lovi-sim-{index:04d}"
+        mac = "02:AB:" + ":".join(f"{(index >> s) & 0xFF:02X}" for s in (24, 16, 8, 0))
+        info = AsyncServiceInfo(
+            ZEROCONF_SERVICE_TYPE,
+            f"{hostname}.{ZEROCONF_SERVICE_TYPE}",
+            addresses=[socket.inet_aton(socket.gethostbyname(self._args.host))],
+            port=port,
+            properties={
+                "mac": mac,
+                "model": "Lovi Device",
+                "device_type": "presence_gen_one",
+                "firmware_version": "sim",
+            },
+            server=f"{hostname}.local.",
+        )
+        await self._zeroconf.async_register_service(info)
+
+    async def _shutdown(self) -> None:
+        """Withdraw mDNS records and stop the simulator."""
+        if self._zeroconf is not None:
+            await self._zeroconf.async_unregister_all_services()
+            await self._zeroconf.async_close()
+        if self._simulator is not None:
+            self._simulator.terminate()
+            await self._simulator.wait()
+        if self._certificates is not None:
+            self._certificates.cleanup()
+
+    @staticmethod
+    def _report(count: int, phase: PhaseStats, cpu: float) -> None:
+        """Print one step of the report.
+
+        Args:
+            count: Devices polled during the step
+            phase: Measurements from the step
+            cpu: Process CPU time per wall second
+        """
+        latencies = phase.latencies
+        lags = phase.loop_lags
+        print(
+            f"{count:8d} {len(latencies):10d} {phase.errors:7d} "
+            f"{_percentile(latencies, 50) * 1000:8.1f} "
+            f"{_percentile(latencies, 95) * 1000:8.1f} "
+            f"{_percentile(latencies, 99) * 1000:8.1f} "
+            f"{cpu * 100:7.1f} "
+            f"{_percentile(lags, 99) * 1000:8.1f} "
+            f"{max(lags, default=0.0) * 1000:8.1f}",
+            flush=True,
+        )
+
+
+def _parse_args() -> argparse.Namespace:
+    """Parse the command line.
+
+    Returns:
+        Parsed arguments
+    """
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "--steps",
+        type=lambda text: [int(step) for step in text.split(",")],
+        default=[100, 200, 300, 400, 500],
+        help="comma separated fleet sizes to ramp through",
+    )
+    parser.add_argument("--duration", type=float, default=60, help="seconds per step")
+    parser.add_argument(
+        "--interval", type=float, default=UPDATE_INTERVAL, help="seconds between refreshes"
+    )
+    parser.add_argument("--host", default="127.0.0.1", help="simulator address")
+    parser.add_argument("--port", type=int, default=18000, help="port of the first device")
+    parser.add_argument(
+        "--delay-ms", type=int, default=30, help="simulated device response time"
+    )
+    parser.add_argument(
+        "--simulator", type=Path, default=DEFAULT_SIMULATOR, help="fleet simulator binary"
+    )
+    parser.add_argument(
+        "--no-spawn", action="store_true", help="use a simulator that is already running"
+    )
+    parser.add_argument(
+        "--api-key", help="require this X-API-Key on every endpoint but /api/device"
+    )
+    parser.add_argument(
+        "--https", action="store_true", help="serve and poll over TLS like -DLOVI_TLS=1"
+    )
+    parser.add_argument(
+        "--mdns",
+        action="store_true",
+        help="advertise every simulated device over mDNS; a Home Assistant "
+        "instance on the network will discover them",
+    )
+    args = parser.parse_args()
+    if args.steps != sorted(args.steps):
+        parser.error("--steps must be increasing")
+    return args
+
+
+if __name__ == "__main__":
+    asyncio.run(FleetLoadTest(_parse_args()).run())
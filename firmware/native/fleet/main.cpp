@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include <csignal>
+#include <cstdio>
+#include <vector>
+#include "FleetServer.h"
+#include "SimDevice.h"
+
+using namespace lovi;
+
+static const uint32_t SAMPLE_INTERVAL_MS = 100;
+
+static void _usage(const char* program) {
+    fprintf(stderr, "usage: %s [--devices N] [--port BASE] [--delay-ms MS] [--api-key KEY]\n"
+                    "       [--tls-cert PEM --tls-key PEM]\n", program);
+}
+
+int main(int argc, char** argv) {
+    unsigned devices = 100;
+    unsigned basePort = 18000;
+    unsigned delayMs = 0;
+    const char* apiKey = nullptr;
+    const char* certPath = nullptr;
+    const char* keyPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && !strcmp(argv[i], "--devices")) {
+            devices = strtoul(argv[++i], nullptr, 10);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--port")) {
+            basePort = strtoul(argv[++i], nullptr, 10);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--delay-ms")) {
+            delayMs = strtoul(argv[++i], nullptr, 10);
+        } else if (i + 1 < argc && !strcmp(argv[i], "--api-key")) {
+            apiKey = argv[++i];
+        } else if (i + 1 < argc && !strcmp(argv[i], "--tls-cert")) {
+            certPath = argv[++i];
+        } else if (i + 1 < argc && !strcmp(argv[i], "--tls-key")) {
+            keyPath = argv[++i];
+        } else {
+            _usage(argv[0]);
+            return 2;
+        }
+    }
+    if (devices == 0 || basePort + devices > 65536 || !certPath != !keyPath) {
+        _usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<SimDevice> fleet;
+    fleet.reserve(devices);
+    for (unsigned i = 0; i < devices; i++) {
+        fleet.emplace_back(static_cast<uint16_t>(i), 0x9E3779B9u * (i + 1));
+    }
+
+    // Peers that hang up mid-response must not kill the simulator.
+    signal(SIGPIPE, SIG_IGN);
+
+    FleetServer server(fleet, static_cast<uint16_t>(basePort), delayMs);
+    server.setApiKey(apiKey);
+    if ((certPath && !server.setCertificate(certPath, keyPath)) || !server.begin()) {
+        return 1;
+    }
+    // The load test waits for this line before it starts polling.
+    printf("ready %u devices on ports %u-%u\n", devices, basePort, basePort + devices - 1);
+    fflush(stdout);
+
+    uint32_t lastSampleMs = 0;
+    while (true) {
+        uint32_t nowMs = millis();
+        if (nowMs - lastSampleMs >= SAMPLE_INTERVAL_MS) {
+            lastSampleMs = nowMs;
+            for (SimDevice& device : fleet) {
+                device.update(nowMs);
+            }
+        }
+        server.update(static_cast<int>(SAMPLE_INTERVAL_MS));
+    }
+}
@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include <coredecls.h>
+#include <spi_flash.h>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+
+// ConfigManager derives its sector from this linker symbol; any address
+// works because emulated flash is keyed by sector number.
+extern "C" {
+uint32_t _EEPROM_start;
+}
+
+static const auto _start = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - _start).count());
+}
+
+uint32_t micros() {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - _start).count());
+}
+
+void (*delayHook)() = nullptr;
+
+void delay(uint32_t ms) {
+    if (delayHook) {
+        delayHook();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+}
+
+uint32_t _gpioPinConfig[16];
+
+static const uint32_t LEVEL_REFIRE_LIMIT = 100;
+
+struct PinState {
+    int level;
+    void (*handler)(void*);
+    void* arg;
+};
+
+static PinState _pins[16];
+
+void pinMode(uint8_t, uint8_t) {
+}
+
+int digitalRead(uint8_t pin) {
+    return _pins[pin & 0xF].level;
+}
+
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode) {
+    PinState& state = _pins[pin & 0xF];
+    state.handler = handler;
+    state.arg = arg;
+    GPC(pin) = (GPC(pin) & ~(0xF << GPCI)) | ((mode & 0xF) << GPCI);
+}
+
+void detachInterrupt(uint8_t pin) {
+    _pins[pin & 0xF].handler = nullptr;
+    GPC(pin) &= ~(0xF << GPCI);
+}
+
+static bool _triggered(uint8_t pin, int previous, int level) {
+    switch ((GPC(pin) >> GPCI) & 7) {
+        case RISING:
+            return previous == LOW && level == HIGH;
+        case FALLING:
+            return previous == HIGH && level == LOW;
+        case CHANGE:
+            return previous != level;
+        case ONLOW:
+            return level == LOW;
+        case ONHIGH:
+            return level == HIGH;
+        default:
+            return false;
+    }
+}
+
+uint32_t setInputLevel(uint8_t pin, int level) {
+    PinState& state = _pins[pin & 0xF];
+    int previous = state.level;
+    state.level = level;
+
+    uint32_t calls = 0;
+    bool fire = _triggered(pin, previous, level);
+    while (fire && state.handler && calls < LEVEL_REFIRE_LIMIT) {
+        state.handler(state.arg);
+        calls++;
+        uint8_t type = (GPC(pin) >> GPCI) & 7;
+        fire = (type == ONLOW || type == ONHIGH) && _triggered(pin, level, level);
+    }
+    return calls;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        write(buffer[i]);
+    }
+    return size;
+}
+
+size_t Print::print(const char* text) {
+    return write(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+size_t Print::print(long value) {
+    return print(std::to_string(value).c_str());
+}
+
+size_t Print::print(unsigned long value) {
+    return print(std::to_string(value).c_str());
+}
+
+size_t Print::println() {
+    return print("\r\n");
+}
+
+static std::vector<uint8_t>& _sector(uint32_t sector) {
+    static std::unordered_map<uint32_t, std::vector<uint8_t>> flash;
+    std::vector<uint8_t>& data = flash[sector];
+    if (data.empty()) {
+        data.assign(SPI_FLASH_SEC_SIZE, 0xFF);
+    }
+    return data;
+}
+
+bool EspClass::flashEraseSector(uint32_t sector) {
+    // The host sector number can exceed the 32-bit address space that
+    // flashWrite() and flashRead() see; wrap it the same way.
+    sector = static_cast<uint32_t>(sector * SPI_FLASH_SEC_SIZE) / SPI_FLASH_SEC_SIZE;
+    _sector(sector).assign(SPI_FLASH_SEC_SIZE, 0xFF);
+    return true;
+}
+
+int32_t flashWritesLeft = -1;
+
+bool EspClass::flashWrite(uint32_t address, const uint32_t* data, size_t size) {
+    if (flashWritesLeft == 0) {
+        return false;
+    }
+    if (flashWritesLeft > 0) {
+        flashWritesLeft--;
+    }
+    if (address % 4 || size % 4 || address % SPI_FLASH_SEC_SIZE + size > SPI_FLASH_SEC_SIZE) {
+        return false;
+    }
+    std::vector<uint8_t>& sector = _sector(address / SPI_FLASH_SEC_SIZE);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        sector[address % SPI_FLASH_SEC_SIZE + i] &= bytes[i];
+    }
+    return true;
+}
+
+bool EspClass::flashRead(uint32_t address, uint32_t* data, size_t size) {
+    if (address % 4 || address % SPI_FLASH_SEC_SIZE + size > SPI_FLASH_SEC_SIZE) {
+        return false;
+    }
+    const std::vector<uint8_t>& sector = _sector(address / SPI_FLASH_SEC_SIZE);
+    memcpy(data, sector.data() + address % SPI_FLASH_SEC_SIZE, size);
+    return true;
+}
+
+uint32_t crc32(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (length--) {
+        uint8_t c = *bytes++;
+        for (uint32_t i = 0x80; i > 0; i >>= 1) {
+            bool bit = crc & 0x80000000;
+            if (c & i) {
+                bit = !bit;
+            }
+            crc <<= 1;
+            if (bit) {
+                crc ^= 0x04c11db7;
+            }
+        }
+    }
+    return crc;
+}
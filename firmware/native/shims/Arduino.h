@@ -0,0 +1,125 @@
+#pragma once
+
+// Host stand-in for the subset of the Arduino/ESP8266 core that the
+// platform-independent lovi-core modules use. Flash is emulated in RAM
+// with NOR semantics (erase to 0xFF, writes can only clear bits), and GPIO
+// pins with their interrupt type and wake-enable register bits.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define PROGMEM
+#define PGM_P const char*
+#define IRAM_ATTR
+#define F(text) (text)
+
+typedef uint8_t byte;
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x00
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define ONLOW 0x04
+#define ONHIGH 0x05
+
+// Per-pin GPIO configuration: interrupt type in bits 7-9, wake enable in bit 10.
+extern uint32_t _gpioPinConfig[16];
+#define GPC(pin) _gpioPinConfig[(pin) & 0xF]
+#define GPCI 7
+#define GPCWE 10
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+void attachInterruptArg(uint8_t pin, void (*handler)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// Host only: drives an input pin and runs its handler the way the GPIO block
+// would. A level trigger re-fires for as long as the handler leaves it armed
+// and the level holds, up to a limit; returns the number of handler calls.
+uint32_t setInputLevel(uint8_t pin, int level);
+// Host only: runs inside delay(), where the device would be idle or asleep.
+extern void (*delayHook)();
+// Host only: once this many flash writes have succeeded, the rest fail as if
+// power was lost. Negative means unlimited.
+extern int32_t flashWritesLeft;
+
+class String {
+public:
+    String(const char* text = "") : _text(text ? text : "") {}
+
+    const char* c_str() const { return _text.c_str(); }
+    size_t length() const { return _text.size(); }
+    char operator[](size_t index) const { return _text[index]; }
+    bool operator==(const String& other) const { return _text == other._text; }
+    bool operator!=(const String& other) const { return _text != other._text; }
+    String& operator+=(const String& other) {
+        _text += other._text;
+        return *this;
+    }
+
+private:
+    std::string _text;
+};
+
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t byte) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    size_t print(const char* text);
+    size_t print(long value);
+    size_t print(unsigned long value);
+    size_t print(int value) { return print(static_cast<long>(value)); }
+    size_t print(unsigned int value) { return print(static_cast<unsigned long>(value)); }
+    size_t println();
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// Output is discarded so benchmark timings do not include terminal I/O.
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t) override { return 1; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+    bool flashEraseSector(uint32_t sector);
+    bool flashWrite(uint32_t address, const uint32_t* data, size_t size);
+    bool flashRead(uint32_t address, uint32_t* data, size_t size);
+
+    uint8_t getCpuFreqMHz() { return 80; }
+    uint32_t getCycleCount() { return micros() * getCpuFreqMHz(); }
+    uint32_t random() { return static_cast<uint32_t>(::random()); }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,23 @@
+#include <ESP8266WiFi.h>
+
+extern "C" {
+#include <user_interface.h>
+}
+
+ESP8266WiFiClass WiFi;
+
+// Like the SDK, arming a wake pin replaces its interrupt type with the
+// level, and disarming clears wake enable but leaves that type in place.
+extern "C" void wifi_enable_gpio_wakeup(uint32_t pin, GPIO_INT_TYPE type) {
+    GPC(pin) = (GPC(pin) & ~(7 << GPCI)) | (type << GPCI) | (1 << GPCWE);
+}
+
+extern "C" void wifi_disable_gpio_wakeup(void) {
+    for (uint8_t pin = 0; pin < 16; pin++) {
+        GPC(pin) &= ~(1 << GPCWE);
+    }
+}
+
+extern "C" uint8_t system_get_cpu_freq(void) {
+    return ESP.getCpuFreqMHz();
+}
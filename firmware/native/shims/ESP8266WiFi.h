@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+
+enum WiFiSleepType_t { WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2 };
+
+class ESP8266WiFiClass {
+public:
+    bool setSleepMode(WiFiSleepType_t type, uint8_t listenInterval = 0) {
+        _sleepMode = type;
+        (void)listenInterval;
+        return true;
+    }
+    WiFiSleepType_t getSleepMode() const { return _sleepMode; }
+
+private:
+    WiFiSleepType_t _sleepMode = WIFI_NONE_SLEEP;
+};
+
+extern ESP8266WiFiClass WiFi;
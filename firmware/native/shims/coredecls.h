@@ -0,0 +1,6 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Same MSB-first CRC-32 as the ESP8266 core, so records match on-device ones.
+uint32_t crc32(const void* data, size_t length, uint32_t crc = 0xffffffff);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+// The same encoding as the interrupt type bits in GPC().
+typedef enum {
+    GPIO_PIN_INTR_DISABLE = 0,
+    GPIO_PIN_INTR_POSEDGE = 1,
+    GPIO_PIN_INTR_NEGEDGE = 2,
+    GPIO_PIN_INTR_ANYEDGE = 3,
+    GPIO_PIN_INTR_LOLEVEL = 4,
+    GPIO_PIN_INTR_HILEVEL = 5
+} GPIO_INT_TYPE;
+
+void wifi_enable_gpio_wakeup(uint32_t pin, GPIO_INT_TYPE type);
+void wifi_disable_gpio_wakeup(void);
+uint8_t system_get_cpu_freq(void);
@@ -0,0 +1,44 @@
+#include "Check.h"
+#include <cstdio>
+#include <cstring>
+
+namespace lovi {
+namespace check {
+
+static Check* _checks = nullptr;
+static uint32_t _failures = 0;
+
+Registrar::Registrar(Check* check) {
+    // Append so the report keeps source order.
+    Check** tail = &_checks;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = check;
+}
+
+void fail(const char* file, int line, const char* expression) {
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    _failures++;
+}
+
+int runAll(const char* filter) {
+    int failed = 0;
+    for (Check* check = _checks; check; check = check->next) {
+        if (filter && !strstr(check->name, filter)) {
+            continue;
+        }
+
+        uint32_t before = _failures;
+        check->function();
+        bool passed = _failures == before;
+        printf("%-48s %s\n", check->name, passed ? "ok" : "FAIL");
+        if (!passed) {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+}
+}
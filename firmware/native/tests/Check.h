@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+namespace lovi {
+namespace check {
+
+typedef void (*CheckFunction)();
+
+struct Check {
+    const char* name;
+    CheckFunction function;
+    Check* next;
+};
+
+struct Registrar {
+    Registrar(Check* check);
+};
+
+void fail(const char* file, int line, const char* expression);
+
+int runAll(const char* filter);
+
+}
+}
+
+#define LOVI_CHECK_REGISTER(name)                                                       \
+    static void check_##name();                                                         \
+    static ::lovi::check::Check check_##name##_entry = {#name, check_##name, nullptr};  \
+    static ::lovi::check::Registrar check_##name##_registrar(&check_##name##_entry);    \
+    static void check_##name()
+
+// TEST(name) { CHECK(condition); ... }
+#define TEST(name) LOVI_CHECK_REGISTER(name)
+// Reports the failed condition and carries on with the rest of the test.
+#define CHECK(condition)                                             \
+    do {                                                             \
+        if (!(condition)) {                                          \
+            ::lovi::check::fail(__FILE__, __LINE__, #condition);     \
+        }                                                            \
+    } while (0)
@@ -0,0 +1,262 @@
+#include <Arduino.h>
+#include <coredecls.h>
+#include <spi_flash.h>
+#include "Check.h"
+#include "ConfigManager.h"
+#include "History.h"
+#include "InputCapture.h"
+#include "PowerManager.h"
+#include "Scheduler.h"
+
+extern "C" {
+#include <user_interface.h>
+}
+
+extern "C" uint32_t _EEPROM_start;
+
+using namespace lovi;
+
+static const uint8_t WAKE_PIN = 12;
+
+static uint8_t _interruptType(uint8_t pin) {
+    return (GPC(pin) >> GPCI) & 7;
+}
+
+static uint32_t _wakeCalls;
+static uint8_t _wakeTypeWhileAsleep;
+static bool _wakeEnabledWhileAsleep;
+
+// Stands in for the radar raising its output while the CPU sleeps.
+static void _raiseWhileAsleep() {
+    _wakeTypeWhileAsleep = _interruptType(WAKE_PIN);
+    _wakeEnabledWhileAsleep = GPC(WAKE_PIN) & (1 << GPCWE);
+    _wakeCalls = setInputLevel(WAKE_PIN, HIGH);
+}
+
+static void _sampleWhileAsleep() {
+    _wakeTypeWhileAsleep = _interruptType(WAKE_PIN);
+    _wakeEnabledWhileAsleep = GPC(WAKE_PIN) & (1 << GPCWE);
+}
+
+TEST(light_sleep_wake_keeps_input_edges) {
+    setInputLevel(WAKE_PIN, LOW);
+    InputCapture inputs;
+    inputs.addLine(WAKE_PIN);
+    inputs.begin();
+
+    Scheduler scheduler;
+    scheduler.addTask("idle", 5, [] {});
+    PowerManager power(&scheduler);
+    power.addWakePin(WAKE_PIN);
+    power.setMode(PowerMode::LIGHT_SLEEP);
+
+    delayHook = _raiseWhileAsleep;
+    scheduler.run();
+    delayHook = nullptr;
+
+    CHECK(_wakeTypeWhileAsleep == GPIO_PIN_INTR_HILEVEL);
+    CHECK(_wakeEnabledWhileAsleep);
+    // The level is still high, so it must not have re-fired.
+    CHECK(_wakeCalls == 1);
+    CHECK(_interruptType(WAKE_PIN) == CHANGE);
+    CHECK(!(GPC(WAKE_PIN) & (1 << GPCWE)));
+
+    // Awake again, the falling edge still reaches InputCapture.
+    CHECK(setInputLevel(WAKE_PIN, LOW) == 1);
+    InputEdge edge;
+    CHECK(inputs.poll(edge) && edge.active);
+    CHECK(inputs.poll(edge) && !edge.active);
+    CHECK(!inputs.poll(edge));
+    CHECK(inputs.getDroppedCount() == 0);
+
+    power.setMode(PowerMode::PERFORMANCE);
+    inputs.end();
+}
+
+TEST(light_sleep_wakes_on_the_opposite_level) {
+    setInputLevel(WAKE_PIN, HIGH);
+    InputCapture inputs;
+    inputs.addLine(WAKE_PIN);
+    inputs.begin();
+
+    Scheduler scheduler;
+    scheduler.addTask("idle", 5, [] {});
+    PowerManager power(&scheduler);
+    power.addWakePin(WAKE_PIN);
+    power.setMode(PowerMode::LIGHT_SLEEP);
+
+    delayHook = _sampleWhileAsleep;
+    scheduler.run();
+    delayHook = nullptr;
+
+    CHECK(_wakeTypeWhileAsleep == GPIO_PIN_INTR_LOLEVEL);
+    CHECK(_interruptType(WAKE_PIN) == CHANGE);
+
+    InputEdge edge;
+    CHECK(!inputs.poll(edge));
+
+    power.setMode(PowerMode::PERFORMANCE);
+    inputs.end();
+}
+
+TEST(performance_mode_leaves_interrupts_alone) {
+    setInputLevel(WAKE_PIN, LOW);
+    InputCapture inputs;
+    inputs.addLine(WAKE_PIN);
+    inputs.begin();
+
+    Scheduler scheduler;
+    scheduler.addTask("idle", 5, [] {});
+    PowerManager power(&scheduler);
+    power.addWakePin(WAKE_PIN);
+    power.setMode(PowerMode::LIGHT_SLEEP);
+    power.setMode(PowerMode::PERFORMANCE);
+
+    delayHook = _sampleWhileAsleep;
+    scheduler.run();
+    delayHook = nullptr;
+
+    CHECK(_wakeTypeWhileAsleep == CHANGE);
+    CHECK(!_wakeEnabledWhileAsleep);
+
+    inputs.end();
+}
+
+static SensorData _presence(bool present) {
+    SensorData data;
+    data.presence = present;
+    data.distance = 1.5f;
+    return data;
+}
+
+static bool _collect(const History& history, HistoryEntry* entries, size_t count) {
+    History::Cursor cursor = history.since(0);
+    for (size_t i = 0; i < count; i++) {
+        if (!cursor.next(entries[i])) {
+            return false;
+        }
+    }
+    return !cursor.next(entries[0]);
+}
+
+TEST(history_backdated_entry_keeps_time_monotonic) {
+    History history;
+    history.record(1, _presence(true), SENSOR_PRESENCE, 10000);
+    history.record(2, _presence(false), SENSOR_PRESENCE, 9500);
+    history.record(3, _presence(true), SENSOR_PRESENCE, 10300);
+
+    HistoryEntry entries[3];
+    CHECK(_collect(history, entries, 3));
+    CHECK(entries[0].timeMs == 10000);
+    // Without the clamp the negative delta wrapped to the 0xFFFF maximum.
+    CHECK(entries[1].timeMs == 10000);
+    CHECK(entries[2].timeMs == 10300);
+}
+
+TEST(history_spans_millis_wraparound) {
+    History history;
+    history.record(1, _presence(true), SENSOR_PRESENCE, 0xFFFFFF9C);
+    history.record(2, _presence(false), SENSOR_PRESENCE, 0x00000190);
+
+    HistoryEntry entries[2];
+    CHECK(_collect(history, entries, 2));
+    CHECK(entries[0].timeMs == 0xFFFFFF9C);
+    CHECK(entries[1].timeMs == 0x00000190);
+}
+
+static uint8_t _storedSensitivity() {
+    ConfigManager config;
+    config.begin();
+    return config.isConfigured() ? config.getSensitivity() : 0;
+}
+
+// Each save loses power before its record lands, then is retried, across
+// enough saves to wrap both sectors twice.
+TEST(config_survives_power_loss_during_save) {
+    ConfigManager config;
+    config.begin();
+    config.setSSID("lovi-test");
+    config.setSensitivity(1);
+    config.saveConfig();
+
+    for (uint8_t i = 2; i < 2 + 2 * ConfigManager::SLOT_COUNT * ConfigManager::SECTOR_COUNT; i++) {
+        config.setSensitivity(i);
+        flashWritesLeft = 0;
+        config.saveConfig();
+        flashWritesLeft = -1;
+        CHECK(_storedSensitivity() == i - 1);
+
+        config.loadConfig();
+        config.setSensitivity(i);
+        config.saveConfig();
+        CHECK(_storedSensitivity() == i);
+    }
+}
+
+TEST(config_skips_a_torn_record) {
+    ConfigManager config;
+    config.begin();
+    config.setSSID("lovi-test");
+    config.setSensitivity(10);
+    config.saveConfig();
+
+    // The body lands but the header does not.
+    config.setSensitivity(20);
+    flashWritesLeft = 1;
+    config.saveConfig();
+    flashWritesLeft = -1;
+    CHECK(_storedSensitivity() == 10);
+
+    config.loadConfig();
+    config.setSensitivity(30);
+    config.saveConfig();
+    CHECK(_storedSensitivity() == 30);
+}
+
+// Mirrors ConfigManager's record header and payload offsets.
+static const size_t RECORD_HEADER_SIZE = 16;
+static const size_t SENSITIVITY_OFFSET = 32 + 64 + 48;
+
+// A record from newer firmware with fields appended after ours must still
+// load after a downgrade.
+TEST(config_reads_longer_records_from_newer_firmware) {
+    uint32_t sector = ((uintptr_t)&_EEPROM_start - 0x40200000) / SPI_FLASH_SEC_SIZE;
+    ESP.flashEraseSector(sector);
+    ESP.flashEraseSector(sector - 1);
+
+    ConfigManager config;
+    config.begin();
+    config.setSSID("lovi-test");
+    config.setSensitivity(10);
+    config.saveConfig();
+
+    // The first record lands in the spare sector's first slot.
+    uint32_t address = (sector - 1) * SPI_FLASH_SEC_SIZE;
+    alignas(4) uint8_t record[ConfigManager::SLOT_SIZE];
+    CHECK(ESP.flashRead(address, reinterpret_cast<uint32_t*>(record), sizeof(record)));
+
+    uint16_t length;
+    uint32_t sequence;
+    memcpy(&length, record + 6, sizeof(length));
+    memcpy(&sequence, record + 8, sizeof(sequence));
+    uint8_t* body = record + RECORD_HEADER_SIZE;
+    body[SENSITIVITY_OFFSET] = 77;
+    memset(body + length, 0x5A, 16);
+    length += 16;
+    sequence++;
+    uint32_t crc = crc32(body, length);
+    memcpy(record + 6, &length, sizeof(length));
+    memcpy(record + 8, &sequence, sizeof(sequence));
+    memcpy(record + 12, &crc, sizeof(crc));
+    CHECK(ESP.flashWrite(address + ConfigManager::SLOT_SIZE, reinterpret_cast<uint32_t*>(record),
+                         sizeof(record)));
+
+    ConfigManager downgraded;
+    downgraded.begin();
+    CHECK(downgraded.getSensitivity() == 77);
+    CHECK(!strcmp(downgraded.getSSID(), "lovi-test"));
+}
+
+int main(int argc, char** argv) {
+    return lovi::check::runAll(argc > 1 ? argv[1] : nullptr) ? 1 : 0;
+}
@@ -0,0 +1,110 @@
+"""Embed the captive portal assets as gzipped PROGMEM arrays.
+
+Runs as a PlatformIO pre-build script (``extra_scripts = pre:...``) or
+standalone with ``python3 scripts/embed_assets.py``. Every file under
+lib/captiveportal/assets is gzipped and written to PortalAssets.h; the
+header is only rewritten when its content changes so incremental builds
+stay incremental.
+"""
+
+from __future__ import annotations
+
+import gzip
+import os
+import re
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".ico": "image/x-icon",
+}
+
+
+def _firmware_dir() -> str:
+    """Return the firmware directory for both PlatformIO and CLI runs."""
+    try:
+        Import("env")  # type: ignore[name-defined]  # noqa: F821
+        project_dir = env["PROJECT_DIR"]  # type: ignore[name-defined]  # noqa: F821
+        return os.path.normpath(os.path.join(project_dir, "..", ".."))
+    except NameError:
+        return os.path.normpath(os.path.join(os.path.dirname(__file__), ".."))
+
+
+def _symbol(name: str) -> str:
+    """Turn an asset file name into a C identifier."""
+    return "ASSET_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def _render(assets_dir: str) -> str:
+    """Render the header for every asset in assets_dir."""
+    lines = [
+        "#pragma once",
+        "",
+        "// Generated by scripts/embed_assets.py from lib/captiveportal/assets.",
+        "// Do not edit; change the source asset and rebuild.",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "namespace lovi {",
+        "",
+        "struct PortalAsset {",
+        "    const char* path;",
+        "    const char* contentType;",
+        "    const uint8_t* data;",
+        "    size_t length;",
+        "};",
+        "",
+    ]
+    table = []
+
+    for name in sorted(os.listdir(assets_dir)):
+        source = os.path.join(assets_dir, name)
+        if not os.path.isfile(source):
+            continue
+        with open(source, "rb") as handle:
+            # mtime=0 keeps the output byte-identical between builds.
+            data = gzip.compress(handle.read(), compresslevel=9, mtime=0)
+
+        symbol = _symbol(name)
+        lines.append(f"static const uint8_t {symbol}[] PROGMEM = {{")
+        for offset in range(0, len(data), 16):
+            chunk = ", ".join(f"0x{byte:02x}" for byte in data[offset:offset + 16])
+            lines.append(f"    {chunk},")
+        lines.append("};")
+        lines.append("")
+
+        path = "/" if name == "index.html" else f"/{name}"
+        content_type = CONTENT_TYPES.get(os.path.splitext(name)[1], "application/octet-stream")
+        table.append(f'    {{ "{path}", "{content_type}", {symbol}, sizeof({symbol}) }},')
+
+    lines.append("static const PortalAsset PORTAL_ASSETS[] = {")
+    lines.extend(table)
+    lines.append("};")
+    lines.append("static const size_t PORTAL_ASSET_COUNT = sizeof(PORTAL_ASSETS) / sizeof(PORTAL_ASSETS[0]);")
+    lines.append("")
+    lines.append("}")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main() -> None:
+    """Regenerate PortalAssets.h if any asset changed."""
+    portal_dir = os.path.join(_firmware_dir(), "lib", "captiveportal")
+    header = os.path.join(portal_dir, "PortalAssets.h")
+    content = _render(os.path.join(portal_dir, "assets"))
+
+    if os.path.exists(header):
+        with open(header, encoding="utf-8") as handle:
+            if handle.read() == content:
+                return
+
+    with open(header, "w", encoding="utf-8") as handle:
+        handle.write(content)
+    print(f"Generated {os.path.relpath(header)}")
+
+
+main()
@@ -0,0 +1,82 @@
+"""Create the TLS certificate for builds with -DLOVI_TLS=1.
+
+Runs as a PlatformIO pre-build script in TLS environments, or standalone
+with ``python3 scripts/gen_tls_cert.py <project_dir>``. A self-signed
+ECDSA P-256 certificate is generated with the openssl CLI and written to
+tls_credentials.h in the project directory. An existing header is kept,
+so every build of an install shares one certificate; delete the header
+to rotate it. P-256 keeps the handshake well under a second at 160 MHz,
+where RSA-2048 takes several.
+"""
+
+from __future__ import annotations
+
+import os
+import subprocess
+import sys
+import tempfile
+
+HEADER_NAME = "tls_credentials.h"
+VALID_DAYS = 3650
+
+
+def _project_dir() -> str:
+    """Return the device project directory for both PlatformIO and CLI runs."""
+    try:
+        Import("env")  # type: ignore[name-defined]  # noqa: F821
+        return env["PROJECT_DIR"]  # type: ignore[name-defined]  # noqa: F821
+    except NameError:
+        if len(sys.argv) != 2:
+            sys.exit("usage: gen_tls_cert.py <project_dir>")
+        return sys.argv[1]
+
+
+def _generate() -> tuple[str, str]:
+    """Return a fresh (certificate, key) PEM pair."""
+    with tempfile.TemporaryDirectory() as workdir:
+        key_path = os.path.join(workdir, "key.pem")
+        cert_path = os.path.join(workdir, "cert.pem")
+        subprocess.run(
+            [
+                "openssl", "req", "-x509", "-newkey", "ec",
+                "-pkeyopt", "ec_paramgen_curve:prime256v1", "-nodes",
+                "-keyout", key_path, "-out", cert_path,
+                "-days", str(VALID_DAYS), "-subj", "/CN=lovi.local",
+            ],
+            check=True,
+            capture_output=True,
+        )
+        with open(cert_path, encoding="ascii") as handle:
+            cert = handle.read()
+        with open(key_path, encoding="ascii") as handle:
+            key = handle.read()
+    return cert, key
+
+
+def _render(cert: str, key: str) -> str:
+    """Render the credentials header."""
+    return "\n".join([
+        "#pragma once",
+        "",
+        "// Generated by scripts/gen_tls_cert.py. Keep out of version control.",
+        "",
+        f'static const char TLS_CERT_PEM[] = R"PEM({cert})PEM";',
+        "",
+        f'static const char TLS_KEY_PEM[] = R"PEM({key})PEM";',
+        "",
+    ])
+
+
+def main() -> None:
+    """Write the credentials header unless one already exists."""
+    header = os.path.join(_project_dir(), HEADER_NAME)
+    if os.path.exists(header):
+        return
+
+    cert, key = _generate()
+    with open(header, "w", encoding="ascii") as handle:
+        handle.write(_render(cert, key))
+    print(f"Generated {os.path.relpath(header)}")
+
+
+main()
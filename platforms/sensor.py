@@ -10,7 +10,14 @@ from homeassistant.components.sensor import (
     SensorStateClass,
 )
 from homeassistant.config_entries import ConfigEntry
-from homeassistant.const import PERCENTAGE, UnitOfTemperature, UnitOfTime
+from homeassistant.const import (
+    PERCENTAGE,
+    SIGNAL_STRENGTH_DECIBELS_MILLIWATT,
+    EntityCategory,
+    UnitOfInformation,
+    UnitOfTemperature,
+    UnitOfTime,
+)
 from homeassistant.core import HomeAssistant
 from homeassistant.helpers.device_registry import DeviceInfo
 from homeassistant.helpers.entity_platform import AddEntitiesCallback
@@ -83,6 +90,57 @@ SENSOR_DESCRIPTIONS: list[SensorEntityDescription] = [
 ]
 
 
+# Diagnostic sensors fed from /api/metrics, keyed by (section, field)
+METRIC_DESCRIPTIONS: dict[tuple[str, str], SensorEntityDescription] = {
+    ("heap", "free"): SensorEntityDescription(
+        key="free_heap",
+        name="Free memory",
+        icon="mdi:memory",
+        native_unit_of_measurement=UnitOfInformation.BYTES,
+        device_class=SensorDeviceClass.DATA_SIZE,
+        state_class=SensorStateClass.MEASUREMENT,
+        entity_category=EntityCategory.DIAGNOSTIC,
+        translation_key="free_heap",
+    ),
+    ("heap", "fragmentation"): SensorEntityDescription(
+        key="heap_fragmentation",
+        name="Memory fragmentation",
+        icon="mdi:memory",
+        native_unit_of_measurement=PERCENTAGE,
+        state_class=SensorStateClass.MEASUREMENT,
+        entity_category=EntityCategory.DIAGNOSTIC,
+        translation_key="heap_fragmentation",
+    ),
+    ("wifi", "rssi"): SensorEntityDescription(
+        key="wifi_rssi",
+        name="WiFi signal",
+        icon="mdi:wifi",
+        native_unit_of_measurement=SIGNAL_STRENGTH_DECIBELS_MILLIWATT,
+        device_class=SensorDeviceClass.SIGNAL_STRENGTH,
+        state_class=SensorStateClass.MEASUREMENT,
+        entity_category=EntityCategory.DIAGNOSTIC,
+        translation_key="wifi_rssi",
+    ),
+    ("http", "requests"): SensorEntityDescription(
+        key="http_requests",
+        name="HTTP requests",
+        icon="mdi:counter",
+        state_class=SensorStateClass.TOTAL_INCREASING,
+        entity_category=EntityCategory.DIAGNOSTIC,
+        translation_key="http_requests",
+    ),
+    ("power", "duty_cycle"): SensorEntityDescription(
+        key="duty_cycle",
+        name="Duty cycle",
+        icon="mdi:sleep",
+        native_unit_of_measurement=PERCENTAGE,
+        state_class=SensorStateClass.MEASUREMENT,
+        entity_category=EntityCategory.DIAGNOSTIC,
+        translation_key="duty_cycle",
+    ),
+}
+
+
 def _get_sensor_keys_for_capabilities(
     capabilities: DeviceCapabilities,
 ) -> list[str]:
@@ -131,6 +189,10 @@ async def async_setup_entry(
             entity = LoviSensor(coordinator, description)
             entities.append(entity)
 
+    if coordinator.metrics:
+        for path, description in METRIC_DESCRIPTIONS.items():
+            entities.append(LoviMetricSensor(coordinator, description, path))
+
     async_add_entities(entities)
 
 
@@ -199,3 +261,42 @@ class LoviSensor(CoordinatorEntity, SensorEntity):
     async def async_update(self) -> None:
         """Update the entity."""
         await self.coordinator.async_request_refresh()
+
+
+class LoviMetricSensor(LoviSensor):
+    """Diagnostic sensor reporting a device health metric."""
+
+    def __init__(
+        self,
+        coordinator: LoviDataUpdateCoordinator,
+        description: SensorEntityDescription,
+        path: tuple[str, str],
+    ) -> None:
+        """Initialize the metric sensor.
+
+        Args:
+            coordinator: Data update coordinator
+            description: Entity description
+            path: (section, field) location of the value in /api/metrics
+        """
+        super().__init__(coordinator, description)
+        self._path = path
+
+    @property
+    def native_value(self) -> int | float | None:
+        """Return the metric value."""
+        section, field = self._path
+        return self.coordinator.metrics.get(section, {}).get(field)
+
+    @property
+    def extra_state_attributes(self) -> dict[str, Any] | None:
+        """Return per-task loop timing alongside the request counter."""
+        if self._path != ("http", "requests"):
+            return None
+
+        tasks = self.coordinator.metrics.get("tasks", {})
+        return {
+            f"{name}_{stat}": timing.get(stat)
+            for name, timing in tasks.items()
+            for stat in ("mean_us", "max_us")
+        }